@@ -0,0 +1,457 @@
+#include <benchmark/benchmark.h>
+
+#include <Foo/Core/Common.h>
+#include <Foo/Core/Group.h>
+#include <Foo/Core/OptionalAlgorithm.h>
+#include <Foo/Core/Predicates.h>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Allocation counting - reported as the "allocs/call" counter of every benchmark.
+ *
+ * Qt containers allocate through malloc() rather than operator new, so with glibc malloc() itself is
+ * interposed; elsewhere only operator new is counted.
+ */
+namespace
+{
+	std::atomic<size_t> sAllocations{ 0 };
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* pointer, size_t size);
+
+	void* malloc(size_t size) noexcept
+	{
+		sAllocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t count, size_t size) noexcept
+	{
+		sAllocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* pointer, size_t size) noexcept
+	{
+		sAllocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_realloc(pointer, size);
+	}
+}
+#else
+void* operator new(size_t size)
+{
+	sAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size ? size : 1))
+	{
+		return pointer;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+#endif
+
+namespace
+{
+	class AllocationCounter
+	{
+	public:
+		explicit AllocationCounter(benchmark::State& state)
+			: mState(state)
+			, mStart(sAllocations.load(std::memory_order_relaxed))
+		{
+		}
+
+		~AllocationCounter()
+		{
+			const auto allocations = sAllocations.load(std::memory_order_relaxed) - mStart;
+			mState.counters["allocs/call"] = benchmark::Counter(static_cast<double>(allocations) / static_cast<double>(std::max<benchmark::IterationCount>(mState.iterations(), 1)));
+			mState.SetItemsProcessed(mState.iterations() * mState.range(0));
+		}
+
+	private:
+		benchmark::State&	mState;
+		size_t				mStart;
+	};
+
+	/** Longer than the small string buffer, so that a copy of a city allocates (and shows in allocs/call) */
+	const std::string CITY_PREFIX = "city with a name longer than the small string buffer ";
+
+	struct Address
+	{
+		std::string city;
+	};
+
+	struct Record
+	{
+		int		id;
+		QString	name;
+		Address	address;
+	};
+
+	template <typename T>
+	T make_element(int i);
+
+	template <>
+	int make_element<int>(int i) { return i; }
+
+	template <>
+	float make_element<float>(int i) { return static_cast<float>(i); }
+
+	template <>
+	std::string make_element<std::string>(int i) { return std::to_string(i); }
+
+	template <>
+	QString make_element<QString>(int i) { return QString::number(i); }
+
+	template <>
+	Record make_element<Record>(int i) { return Record{ i, QString::number(i), Address{ CITY_PREFIX + std::to_string(i) } }; }
+
+	template <typename Container>
+	Container make_container(benchmark::State& state)
+	{
+		using ValueType = foo::traits::ValueTypeOf<Container>;
+
+		Container container;
+		for (int i = 0; i < state.range(0); ++i)
+		{
+			container.push_back(make_element<ValueType>(i));
+		}
+		return container;
+	}
+
+	template <typename Container>
+	auto missing_element()
+	{
+		return make_element<foo::traits::ValueTypeOf<Container>>(-1);
+	}
+
+	/** Keeps (roughly) every other element */
+	struct Filter
+	{
+		bool operator()(int i) const { return i % 2 == 0; }
+		bool operator()(float f) const { return static_cast<int>(f) % 2 == 0; }
+		bool operator()(const std::string& text) const { return text.back() % 2 == 0; }
+		bool operator()(const QString& text) const { return text.back().unicode() % 2 == 0; }
+	};
+
+	/** Keeps the element type, so that the non-template containers (QStringList) can be transformed as well */
+	struct Transform
+	{
+		int operator()(int i) const { return i * 2; }
+		float operator()(float f) const { return f * 2; }
+		std::string operator()(const std::string& text) const { return text + "!"; }
+		QString operator()(const QString& text) const { return text + "!"; }
+	};
+
+	/**
+	 * Names of random records, generated up-front so that creating them is neither timed nor counted
+	 */
+	template <typename Key = QString>
+	class RandomKeys
+	{
+	public:
+		RandomKeys(benchmark::State& state, const Key& prefix = {})
+		{
+			std::mt19937 generator(42);
+			std::uniform_int_distribution<int> distribution(0, static_cast<int>(state.range(0)) - 1);
+
+			mKeys.reserve(KEY_COUNT);
+			for (size_t i = 0; i < KEY_COUNT; ++i)
+			{
+				mKeys.push_back(prefix + make_element<Key>(distribution(generator)));
+			}
+		}
+
+		const Key& next()
+		{
+			return mKeys[mNext++ % KEY_COUNT];
+		}
+
+	private:
+		static constexpr size_t KEY_COUNT = 1024;
+
+		std::vector<Key>		mKeys;
+		size_t					mNext = 0;
+	};
+}
+
+template <typename Container>
+void BM_filtered(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::filtered(container, Filter{}));
+	}
+}
+
+template <typename Container>
+void BM_filteredAs(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::filteredAs<std::vector<foo::traits::ValueTypeOf<Container>>>(container, Filter{}));
+	}
+}
+
+template <typename Container>
+void BM_transformed(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::transformed(container, Transform{}));
+	}
+}
+
+template <typename Container>
+void BM_transformedAs(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::transformedAs<std::vector<foo::traits::ValueTypeOf<Container>>>(container, Transform{}));
+	}
+}
+
+/** Worst case - the element is not there */
+template <typename Container>
+void BM_find(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	const auto missing = missing_element<Container>();
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::find(container, missing));
+	}
+}
+
+template <typename Container>
+void BM_find_scalar(benchmark::State& state)
+{
+	const auto container = make_container<Container>(state);
+	const auto missing = missing_element<Container>();
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(std::find(container.begin(), container.end(), missing));
+	}
+}
+
+template <typename Container>
+void BM_filtered_lambda(benchmark::State& state)
+{
+	using T = foo::traits::ValueTypeOf<Container>;
+
+	const auto container = make_container<Container>(state);
+	const auto low = static_cast<T>(state.range(0) / 4);
+	const auto high = static_cast<T>(state.range(0) / 2);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::filtered(container, [=](T value) { return low <= value && value <= high; }));
+	}
+}
+
+template <typename Container>
+void BM_filtered_predicate(benchmark::State& state)
+{
+	using T = foo::traits::ValueTypeOf<Container>;
+
+	const auto container = make_container<Container>(state);
+	const auto low = static_cast<T>(state.range(0) / 4);
+	const auto high = static_cast<T>(state.range(0) / 2);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::filtered(container, foo::in_range(low, high)));
+	}
+}
+
+template <typename Container>
+void BM_find_selector(benchmark::State& state)
+{
+	const auto records = make_container<Container>(state);
+	RandomKeys<> keys(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::find(records, &Record::name, keys.next()));
+	}
+}
+
+template <typename Container>
+void BM_find_ref(benchmark::State& state)
+{
+	auto records = make_container<Container>(state);
+	RandomKeys<> keys(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::find_ref(records, &Record::name, keys.next()));
+	}
+}
+
+template <typename Container>
+void BM_find_if(benchmark::State& state)
+{
+	const auto records = make_container<Container>(state);
+	RandomKeys<> keys(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		const auto& key = keys.next();
+		benchmark::DoNotOptimize(foo::find_if(records, [&](const Record& record) { return record.name == key; }));
+	}
+}
+
+/** Nested member-pointer chain onto a std::string - should cost the same as BM_find_selector, i.e. copy nothing */
+template <typename Container>
+void BM_find_chained(benchmark::State& state)
+{
+	const auto records = make_container<Container>(state);
+	const auto city = foo::chained(&Record::address, &Address::city);
+	RandomKeys<std::string> keys(state, CITY_PREFIX);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::find(records, city, keys.next()));
+	}
+}
+
+void BM_chained_invocation(benchmark::State& state)
+{
+	const auto records = make_container<std::vector<Record>>(state);
+	const auto city = foo::chained(&Record::address, &Address::city);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		for (const auto& record : records)
+		{
+			benchmark::DoNotOptimize(city(record).size());
+		}
+	}
+}
+
+/** 256 groups of records */
+template <typename Policy>
+void BM_grouped_by(benchmark::State& state)
+{
+	const auto records = make_container<std::vector<Record>>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::grouped_by(Policy{}, records, [](const Record& record) { return record.id % 256; }));
+	}
+}
+
+template <typename Policy>
+void BM_aggregated_by(benchmark::State& state)
+{
+	const auto records = make_container<std::vector<Record>>(state);
+	AllocationCounter counter(state);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(foo::aggregated_by(Policy{}, records, [](const Record& record) { return record.id % 256; }, 0,
+													[](int sum, const Record& record) { return sum + record.id; }, std::plus<>{}));
+	}
+}
+
+#define FOO_BENCHMARK_SIZES ->RangeMultiplier(16)->Range(16, 1 << 20)
+
+#define FOO_BENCHMARK_CONTAINERS(Benchmark, Element) \
+	BENCHMARK_TEMPLATE(Benchmark, std::vector<Element>) FOO_BENCHMARK_SIZES; \
+	BENCHMARK_TEMPLATE(Benchmark, QVector<Element>) FOO_BENCHMARK_SIZES; \
+	BENCHMARK_TEMPLATE(Benchmark, QList<Element>) FOO_BENCHMARK_SIZES
+
+FOO_BENCHMARK_CONTAINERS(BM_filtered, int);
+FOO_BENCHMARK_CONTAINERS(BM_filtered, QString);
+FOO_BENCHMARK_CONTAINERS(BM_filtered, std::string);
+BENCHMARK_TEMPLATE(BM_filtered, QStringList) FOO_BENCHMARK_SIZES;
+
+FOO_BENCHMARK_CONTAINERS(BM_filteredAs, int);
+FOO_BENCHMARK_CONTAINERS(BM_filteredAs, QString);
+BENCHMARK_TEMPLATE(BM_filteredAs, QStringList) FOO_BENCHMARK_SIZES;
+
+FOO_BENCHMARK_CONTAINERS(BM_transformed, int);
+FOO_BENCHMARK_CONTAINERS(BM_transformed, QString);
+FOO_BENCHMARK_CONTAINERS(BM_transformed, std::string);
+BENCHMARK_TEMPLATE(BM_transformed, QStringList) FOO_BENCHMARK_SIZES;
+
+FOO_BENCHMARK_CONTAINERS(BM_transformedAs, int);
+FOO_BENCHMARK_CONTAINERS(BM_transformedAs, QString);
+BENCHMARK_TEMPLATE(BM_transformedAs, QStringList) FOO_BENCHMARK_SIZES;
+
+FOO_BENCHMARK_CONTAINERS(BM_find, int);
+FOO_BENCHMARK_CONTAINERS(BM_find, float);
+FOO_BENCHMARK_CONTAINERS(BM_find, QString);
+BENCHMARK_TEMPLATE(BM_find, QStringList) FOO_BENCHMARK_SIZES;
+
+// vectorized kernels vs. the scalar path
+BENCHMARK_TEMPLATE(BM_find_scalar, std::vector<int>) FOO_BENCHMARK_SIZES;
+BENCHMARK_TEMPLATE(BM_find_scalar, std::vector<float>) FOO_BENCHMARK_SIZES;
+FOO_BENCHMARK_CONTAINERS(BM_filtered_lambda, int);
+FOO_BENCHMARK_CONTAINERS(BM_filtered_predicate, int);
+BENCHMARK_TEMPLATE(BM_filtered_lambda, std::vector<float>) FOO_BENCHMARK_SIZES;
+BENCHMARK_TEMPLATE(BM_filtered_predicate, std::vector<float>) FOO_BENCHMARK_SIZES;
+
+FOO_BENCHMARK_CONTAINERS(BM_find_selector, Record);
+FOO_BENCHMARK_CONTAINERS(BM_find_ref, Record);
+FOO_BENCHMARK_CONTAINERS(BM_find_if, Record);
+FOO_BENCHMARK_CONTAINERS(BM_find_chained, Record);
+BENCHMARK(BM_chained_invocation) FOO_BENCHMARK_SIZES;
+
+BENCHMARK_TEMPLATE(BM_grouped_by, foo::execution::sequenced_policy) FOO_BENCHMARK_SIZES;
+BENCHMARK_TEMPLATE(BM_grouped_by, foo::execution::parallel_policy) FOO_BENCHMARK_SIZES;
+BENCHMARK_TEMPLATE(BM_aggregated_by, foo::execution::sequenced_policy) FOO_BENCHMARK_SIZES;
+BENCHMARK_TEMPLATE(BM_aggregated_by, foo::execution::parallel_policy) FOO_BENCHMARK_SIZES;
+
+BENCHMARK_MAIN();
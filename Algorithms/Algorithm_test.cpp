@@ -1,9 +1,17 @@
 #include <Foo/External/catch.hpp>
 
 #include <Foo/Core/Common.h>
+#include <Foo/Core/Group.h>
+#include <Foo/Core/Pipeline.h>
+#include <Foo/Core/Predicates.h>
 #include <Foo/Core/QtUtils.h>
 #include <Foo/Models/TypedObjectListModel.h>
 
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+
 
 TEST_CASE("filtered")
 {
@@ -37,6 +45,67 @@ TEST_CASE("filtered")
 
 		CHECK(short_named.size() == 2);
 	}
+
+	SECTION("temporaries are compacted in place")
+	{
+		std::vector<int> numbers{1, 2, 3, 4, 5};
+		const auto buffer = numbers.data();
+
+		auto even_numbers = foo::filtered(std::move(numbers), [](int i){ return i % 2 == 0; });
+
+		CHECK(even_numbers == std::vector<int>{2, 4});
+		CHECK(even_numbers.data() == buffer);
+	}
+
+	SECTION("temporaries of elements which cannot be move-assigned are copied")
+	{
+		struct Named { const std::string name; };
+
+		auto long_named = foo::filtered(std::vector<Named>{ { "one" }, { "three" } }, [](const Named& named){ return named.name.size() > 3; });
+
+		REQUIRE(long_named.size() == 1);
+		CHECK(long_named.front().name == "three");
+	}
+
+	SECTION("selective vectorized filters allocate only for the matching elements")
+	{
+		std::vector<int> numbers(100000);
+		std::iota(numbers.begin(), numbers.end(), 0);
+
+		auto few = foo::filtered(numbers, foo::in_range(10, 12));
+
+		CHECK(few == std::vector<int>{10, 11, 12});
+		CHECK(few.capacity() < numbers.size() / 100);
+	}
+
+	SECTION("comparison predicates give the same results as lambdas")
+	{
+		QVector<int> numbers;
+		for (int i = -50; i < 50; ++i)
+		{
+			numbers.append(i * 7 % 23);
+		}
+
+		CHECK(foo::filtered(numbers, foo::in_range(-5, 5)) == foo::filtered(numbers, [](int i){ return -5 <= i && i <= 5; }));
+		CHECK(foo::filtered(numbers, foo::not_equal_to(0)) == foo::filtered(numbers, [](int i){ return i != 0; }));
+
+		std::vector<float> values{0.5f, -1.f, 2.f, 3.5f, -0.f, 8.f, 1.f, -3.f, 7.5f};
+		CHECK(foo::filtered(values, foo::greater_than(1.f)) == std::vector<float>{2.f, 3.5f, 8.f, 7.5f});
+	}
+
+	SECTION("parallel execution policies keep the input order")
+	{
+		std::vector<int> numbers(100000);
+		std::iota(numbers.begin(), numbers.end(), 0);
+		const auto is_even = [](int i){ return i % 2 == 0; };
+
+		const auto expected = foo::filtered(numbers, is_even);
+
+		CHECK(foo::filtered(foo::execution::seq, numbers, is_even) == expected);
+		CHECK(foo::filtered(foo::execution::par, numbers, is_even) == expected);
+		CHECK(foo::filtered(foo::execution::par_unseq, numbers, is_even) == expected);
+		CHECK(foo::filteredAs<QVector<int>>(foo::execution::par, numbers, is_even).size() == 50000);
+	}
 }
 
 TEST_CASE("transformed")
@@ -73,4 +142,238 @@ TEST_CASE("transformed")
 		auto names = foo::transformedAs<QStringList>(objects, [](auto obj) { return obj->objectName(); });
 		CHECK(names == QStringList{ "one" });
 	}
+
+	SECTION("temporaries reuse their storage when the element type does not change")
+	{
+		std::vector<std::string> texts{"one", "two"};
+		const auto buffer = texts.data();
+
+		auto exclaimed = foo::transformed(std::move(texts), [](std::string str) { return str + "!"; });
+		CHECK(exclaimed == std::vector<std::string>{"one!", "two!"});
+		CHECK(exclaimed.data() == buffer);
+
+		auto sizes = foo::transformed(std::vector<std::string>{"one"}, [](const std::string& str) { return str.size(); });
+		CHECK(sizes == std::vector<size_t>{3});
+	}
+
+	SECTION("temporaries can be transformed by functions taking lvalue references")
+	{
+		auto sizes = foo::transformedAs<std::vector<size_t>>(std::vector<std::string>{"one", "three"}, [](auto& str) { return str.size(); });
+		CHECK(sizes == std::vector<size_t>{3, 5});
+
+		auto exclaimed = foo::transformed(std::vector<std::string>{"one"}, [](std::string& str) { return str + "!"; });
+		CHECK(exclaimed == std::vector<std::string>{"one!"});
+	}
+
+	SECTION("parallel execution policies keep the input order and container deduction")
+	{
+		QVector<int> numbers(100000);
+		std::iota(numbers.begin(), numbers.end(), 0);
+		const auto halved = [](int i) { return i / 2.0; };
+
+		QVector<double> result = foo::transformed(foo::execution::par, numbers, halved);
+		CHECK(result == foo::transformed(numbers, halved));
+
+		auto as_vector = foo::transformedAs<std::vector<double>>(foo::execution::par_unseq, numbers, halved);
+		CHECK(as_vector.size() == 100000);
+		CHECK(as_vector.back() == 99999 / 2.0);
+
+		QStringList texts{"one", "two"};
+		CHECK(foo::transformed(foo::execution::par, texts, [](auto str) { return str.toUpper(); }) == QStringList{"ONE", "TWO"});
+	}
+}
+
+TEST_CASE("caller-provided output and allocators")
+{
+	std::vector<int> numbers{1, 2, 3, 4};
+	std::pmr::monotonic_buffer_resource arena;
+
+	SECTION("output containers can be constructed from a memory resource")
+	{
+		auto even = foo::filteredAs<std::pmr::vector<int>>(numbers, [](int i){ return i % 2 == 0; }, &arena);
+		auto halved = foo::transformedAs<std::pmr::vector<double>>(numbers, [](int i){ return i / 2.0; }, &arena);
+
+		CHECK(even.get_allocator().resource() == &arena);
+		CHECK(halved.get_allocator().resource() == &arena);
+		CHECK(even.size() == 2);
+		CHECK(halved.size() == 4);
+	}
+
+	SECTION("results can be appended to an existing container")
+	{
+		std::pmr::vector<long> output({ 0 }, &arena);
+
+		foo::transformed_into(numbers, output, [](int i){ return long(i) * 10; });
+		foo::filtered_into(numbers, output, [](int i){ return i > 2; });
+
+		CHECK(output == std::pmr::vector<long>{ 0, 10, 20, 30, 40, 3, 4 });
+	}
+
+	SECTION("a reused output grows geometrically")
+	{
+		std::vector<std::string> output;
+		int reallocations = 0;
+		for (int i = 0; i < 1000; ++i)
+		{
+			const auto buffer = output.data();
+			foo::transformed_into(numbers, output, [](int number){ return std::to_string(number); });
+			reallocations += output.data() != buffer ? 1 : 0;
+		}
+
+		CHECK(output.size() == 4000);
+		CHECK(reallocations < 20);
+	}
+}
+
+TEST_CASE("transformed_streamed")
+{
+	SECTION("input iterators are transformed in chunks of bounded size")
+	{
+		std::istringstream stream("1 2 3 4 5 6 7");
+		std::vector<std::vector<int>> chunks;
+
+		const auto count = foo::transformed_streamed(std::istream_iterator<int>(stream), std::istream_iterator<int>(), [](int i){ return i * 10; },
+													 [&](std::vector<int>& chunk){ chunks.push_back(std::move(chunk)); }, 3);
+
+		CHECK(count == 7);
+		CHECK(chunks == std::vector<std::vector<int>>{ {10, 20, 30}, {40, 50, 60}, {70} });
+	}
+
+	SECTION("whole ranges can be streamed")
+	{
+		const QStringList texts{ "a", "bb", "ccc" };
+		std::vector<int> sizes;
+
+		foo::transformed_streamed(texts, &QString::size, [&](const std::vector<int>& chunk){ sizes.insert(sizes.end(), chunk.begin(), chunk.end()); });
+
+		CHECK(sizes == std::vector<int>{ 1, 2, 3 });
+	}
+}
+
+TEST_CASE("filter_transformed and transformed_if")
+{
+	SECTION("filter_transformed matches transformed(filtered())")
+	{
+		QVector<int> numbers{1, 2, 3, 4, 5, 6};
+		const auto is_even = [](int i){ return i % 2 == 0; };
+		const auto halved = [](int i){ return i / 2.0; };
+
+		auto fused = foo::filter_transformed(numbers, is_even, halved);
+		CHECK(fused == foo::transformed(foo::filtered(numbers, is_even), halved));
+		CHECK(fused.capacity() >= numbers.size());
+
+		auto shrunk = foo::filter_transformed(numbers, is_even, halved, foo::ShrinkToFit::Yes);
+		CHECK(shrunk == fused);
+		CHECK(shrunk.capacity() == 3);
+	}
+
+	SECTION("transformed_if filters the transformed values")
+	{
+		QStringList texts{"1", "x", "30"};
+
+		auto numbers = foo::transformed_ifAs<std::vector<int>>(texts, [](const QString& text){ return text.toInt(); }, [](int i){ return i > 0; });
+		CHECK(numbers == std::vector<int>{1, 30});
+	}
+
+	SECTION("can specify output type when working with TypedObjectListModel")
+	{
+		const auto new_object = [](auto name) { auto object = new QObject; object->setObjectName(name); return object; };
+		foo::models::Model<QObject> objects { QObjectList{ } << new_object("one") << new_object("three") };
+
+		auto names = foo::filter_transformedAs<QStringList>(objects, [](auto obj) { return obj->objectName().size() < 4; }, &QObject::objectName);
+		CHECK(names == QStringList{ "one" });
+	}
+}
+
+TEST_CASE("grouped_by and aggregated_by")
+{
+	struct Address { QString city; };
+	struct Order { int id; QString customer; Address address; double price; };
+
+	std::vector<Order> orders;
+	for (int id = 0; id < 10000; ++id)
+	{
+		orders.push_back({ id, QString::number(id % 7), Address{ QString("city %1").arg(id % 3) }, 1.5 });
+	}
+
+	SECTION("groups keep the order of the first appearance and the order of their elements")
+	{
+		auto by_city = foo::grouped_by(orders, foo::chained(&Order::address, &Address::city));
+
+		REQUIRE(by_city.size() == 3);
+		CHECK(by_city.begin()->first == "city 0");
+		REQUIRE(by_city.find("city 2").has_value());
+		CHECK(by_city.find("city 2")->get().front().id == 2);
+		CHECK(by_city.find("city 2")->get().size() == 3333);
+		CHECK(!by_city.contains("city 3"));
+	}
+
+	SECTION("the parallel variant gives the same groups")
+	{
+		auto sequential = foo::grouped_by(orders, &Order::customer);
+		auto parallel = foo::grouped_by(foo::execution::par, orders, &Order::customer);
+
+		REQUIRE(parallel.size() == sequential.size());
+		auto ids = [](const std::vector<Order>& group) { return foo::transformed(group, [](const Order& order) { return order.id; }); };
+		for (const auto& [customer, customer_orders] : sequential)
+		{
+			CHECK(ids(parallel.find(customer)->get()) == ids(customer_orders));
+		}
+	}
+
+	SECTION("aggregates are reduced per group, partial aggregates are merged")
+	{
+		auto sum = [](double total, const Order& order) { return total + order.price; };
+		auto revenue = foo::aggregated_by(orders, &Order::customer, 0.0, sum);
+		auto parallel_revenue = foo::aggregated_by(foo::execution::par, orders, &Order::customer, 0.0, sum, std::plus<>{});
+
+		CHECK(revenue.size() == 7);
+		CHECK(revenue.find("0")->get() == Approx(1429 * 1.5));
+		CHECK(parallel_revenue.find("0")->get() == Approx(1429 * 1.5));
+	}
+
+	SECTION("the parallel aggregation applies a non-identity initial value once per group")
+	{
+		const auto sum = [](double total, const Order& order) { return total + order.price; };
+
+		auto revenue = foo::aggregated_by(orders, &Order::customer, 100.0, sum);
+		auto parallel_revenue = foo::aggregated_by(foo::execution::par, orders, &Order::customer, 100.0, 0.0, sum, std::plus<>{});
+
+		REQUIRE(parallel_revenue.size() == 7);
+		CHECK(revenue.find("0")->get() == Approx(100 + 1429 * 1.5));
+		CHECK(parallel_revenue.find("0")->get() == Approx(100 + 1429 * 1.5));
+	}
+}
+
+TEST_CASE("pipeline")
+{
+	SECTION("stages are applied in order and collected into the requested container template")
+	{
+		std::vector<int> numbers{1, 2, 3, 4, 5};
+
+		auto halved_evens = numbers
+				| foo::filter([](int i){ return i % 2 == 0; })
+				| foo::transform([](int i){ return i / 2.0; })
+				| foo::to<QVector>();
+
+		CHECK(halved_evens == QVector<double>{1., 2.});
+	}
+
+	SECTION("matches the eager filtered/transformed chain")
+	{
+		QStringList texts{"one", "two", "three"};
+		const auto is_short = [](const QString& str){ return str.size() < 4; };
+		const auto upper = [](const QString& str){ return str.toUpper(); };
+
+		auto lazy = texts | foo::filter(is_short) | foo::transform(upper) | foo::to<QStringList>();
+		CHECK(lazy == foo::transformed(foo::filtered(texts, is_short), upper));
+	}
+
+	SECTION("member pointers can be used as stages, temporaries are kept alive by the pipeline")
+	{
+		const auto new_object = [](auto name) { auto object = new QObject; object->setObjectName(name); return object; };
+
+		auto names = QObjectList{ new_object("one") } | foo::transform(&QObject::objectName) | foo::to<std::vector>();
+		CHECK(names == std::vector<QString>{ "one" });
+	}
 }
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace foo::execution
+{
+	/**
+	 * Execution policies accepted by the parallel overloads of the foo:: algorithms.
+	 *
+	 * They mirror the std::execution ones, but do not depend on a parallel STL backend being available.
+	 */
+	struct sequenced_policy {};
+	struct parallel_policy {};
+	struct parallel_unsequenced_policy {};
+
+	inline constexpr sequenced_policy				seq{};
+	inline constexpr parallel_policy				par{};
+	inline constexpr parallel_unsequenced_policy	par_unseq{};
+
+	template <typename T>
+	struct IsExecutionPolicy : std::false_type {};
+
+	template <>
+	struct IsExecutionPolicy<sequenced_policy> : std::true_type {};
+
+	template <>
+	struct IsExecutionPolicy<parallel_policy> : std::true_type {};
+
+	template <>
+	struct IsExecutionPolicy<parallel_unsequenced_policy> : std::true_type {};
+
+	template <typename T>
+	constexpr bool IsExecutionPolicy_v = IsExecutionPolicy<std::decay_t<T>>::value;
+}
+
+namespace foo::detail
+{
+	/** Below this many elements per chunk, spawning a worker costs more than it saves */
+	constexpr size_t MIN_CHUNK_SIZE = 512;
+
+	template <typename Policy>
+	size_t chunk_count(Policy, size_t size)
+	{
+		if constexpr (std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>)
+		{
+			return 1;
+		}
+		else
+		{
+			const size_t workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+			return std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, workers);
+		}
+	}
+
+	/**
+	 * State of a for_each_chunk() call, shared with the helper jobs - which may start only after the call returned
+	 */
+	template <typename Iterator, typename ChunkResult>
+	struct ChunkedWork
+	{
+		std::vector<Iterator>					mBounds;
+		std::vector<size_t>						mOffsets;
+		std::vector<std::optional<ChunkResult>>	mResults;
+		std::atomic<size_t>						mNextChunk	= 0;
+
+		std::mutex								mLock;
+		std::condition_variable					mDone;
+		size_t									mDoneCount	= 0;
+		std::exception_ptr						mError;
+
+		/** Processes the chunks nobody has taken yet, @returns false once there are none */
+		template <typename ChunkFunction>
+		bool processNext(ChunkFunction& chunk_function)
+		{
+			const size_t chunk = mNextChunk.fetch_add(1, std::memory_order_relaxed);
+			if (chunk >= mResults.size())
+			{
+				return false;
+			}
+
+			std::exception_ptr error;
+			try
+			{
+				mResults[chunk].emplace(chunk_function(mBounds[chunk], mBounds[chunk + 1], mOffsets[chunk]));
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(mLock);
+			if (error && !mError)
+			{
+				mError = error;
+			}
+			if (++mDoneCount == mResults.size())
+			{
+				mDone.notify_all();
+			}
+			return true;
+		}
+	};
+
+	/**
+	 * Splits [begin, begin + size) into contiguous chunks and invokes \a chunk_function(first, last, offset) on each.
+	 *
+	 * The chunks are taken one by one by the calling thread, and by the jobs posted to the global QThreadPool to help it.
+	 * So no threads are created per call, and a nested call (from a chunk) cannot deadlock nor oversubscribe the pool -
+	 * when all the workers are busy, the calling thread processes all its chunks by itself.
+	 *
+	 * @returns results of \a chunk_function, in the order of the chunks (i.e. in the input order)
+	 *
+	 * @note Exceptions thrown by \a chunk_function are rethrown on the calling thread
+	 */
+	template <typename Policy, typename Iterator, typename ChunkFunction>
+	auto for_each_chunk(Policy policy, Iterator begin, size_t size, ChunkFunction&& chunk_function)
+	{
+		using ChunkResult = std::invoke_result_t<ChunkFunction&, Iterator, Iterator, size_t>;
+
+		const size_t chunks = chunk_count(policy, size);
+		if (chunks == 1)
+		{
+			// not an initializer_list - that would copy the (possibly large, or move-only) result
+			std::vector<ChunkResult> results;
+			results.reserve(1);
+			results.emplace_back(chunk_function(begin, std::next(begin, static_cast<std::ptrdiff_t>(size)), size_t{0}));
+			return results;
+		}
+
+		const size_t chunk_size = size / chunks;
+		const size_t remainder = size % chunks;
+
+		auto work = std::make_shared<ChunkedWork<Iterator, ChunkResult>>();
+		work->mResults.resize(chunks);
+		work->mBounds.reserve(chunks + 1);
+		work->mOffsets.reserve(chunks);
+
+		Iterator position = begin;
+		size_t offset = 0;
+		for (size_t chunk = 0; chunk < chunks; ++chunk)
+		{
+			const size_t length = chunk_size + (chunk < remainder ? 1 : 0);
+			work->mBounds.push_back(position);
+			work->mOffsets.push_back(offset);
+			std::advance(position, length);
+			offset += length;
+		}
+		work->mBounds.push_back(position);
+
+		// the helpers only call chunk_function for a chunk they took, which the calling thread waits for
+		for (size_t helper = 1; helper < chunks; ++helper)
+		{
+			QThreadPool::globalInstance()->start([work, &chunk_function]
+			{
+				while (work->processNext(chunk_function))
+				{
+				}
+			});
+		}
+
+		while (work->processNext(chunk_function))
+		{
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(work->mLock);
+			work->mDone.wait(lock, [&work, chunks] { return work->mDoneCount == chunks; });
+			if (work->mError)
+			{
+				std::rethrow_exception(work->mError);
+			}
+		}
+
+		std::vector<ChunkResult> results;
+		results.reserve(chunks);
+		for (auto& result : work->mResults)
+		{
+			results.push_back(std::move(*result));
+		}
+
+		return results;
+	}
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "Execution.h"
+#include "Simd.h"
+#include "TypeTraits.h"
+
 #include <algorithm>
 #include <memory>
 #include <functional>
@@ -8,14 +12,49 @@ namespace foo
 {
 	/**
 	 * Filters Container<InputType> based on Filter function
+	 *
+	 * @note Comparison predicates from Predicates.h over contiguous int32_t/float containers use vectorized kernels
 	 */
 	template <typename Container, typename Filter, typename OutputContainer = Container>
 	OutputContainer filtered(const Container& container, Filter filter)
 	{
-		OutputContainer filtered_elements;
-		std::copy_if(container.begin(), container.end(), std::back_inserter(filtered_elements), filter);
+		using ValueType = traits::ValueTypeOf<const Container&>;
 
-		return filtered_elements;
+		if constexpr (simd::IsVectorizable_v<ValueType, Filter>
+					  && traits::IsContiguousContainer_v<const Container>
+					  && traits::IsContiguousContainer_v<OutputContainer>
+					  && traits::HasResize_v<OutputContainer>
+					  && std::is_same_v<traits::ValueTypeOf<OutputContainer&>, ValueType>)
+		{
+			// filtered block by block through a small buffer, so that the output only grows with the matching elements
+			using SizeType = decltype(std::declval<OutputContainer>().size());
+
+			const auto data = std::data(container);
+			const auto size = static_cast<size_t>(std::size(container));
+
+			ValueType block[simd::FILTER_BLOCK_SIZE];
+
+			OutputContainer filtered_elements;
+			for (size_t offset = 0; offset < size; offset += simd::FILTER_BLOCK_SIZE)
+			{
+				const auto count = simd::filter(data + offset, std::min(simd::FILTER_BLOCK_SIZE, size - offset), block, filter);
+				if (count != 0)
+				{
+					const auto filtered_size = static_cast<size_t>(filtered_elements.size());
+					filtered_elements.resize(static_cast<SizeType>(filtered_size + count));
+					std::copy_n(block, count, std::data(filtered_elements) + filtered_size);
+				}
+			}
+
+			return filtered_elements;
+		}
+		else
+		{
+			OutputContainer filtered_elements;
+			std::copy_if(container.begin(), container.end(), std::back_inserter(filtered_elements), filter);
+
+			return filtered_elements;
+		}
 	}
 
 	/**
@@ -26,4 +65,129 @@ namespace foo
 	{
 		return filtered<Container, Filter, OutputContainer>(container, filter);
 	}
+
+	/**
+	 * Filters Container<InputType> based on Filter function, appending the elements to a caller-provided \a output
+	 *
+	 * Allows reusing the \a output between calls, or constructing it with an allocator (e.g. backed by a std::pmr arena)
+	 *
+	 * @returns \a output
+	 */
+	template <typename Container, typename OutputContainer, typename Filter>
+	OutputContainer& filtered_into(const Container& container, OutputContainer& output, Filter filter)
+	{
+		std::copy_if(container.begin(), container.end(), std::back_inserter(output), filter);
+		return output;
+	}
+
+	/**
+	 * Filters Container<InputType> based on Filter function into OutputContainer constructed with the \a allocator
+	 *
+	 * @example:
+	 *  std::pmr::monotonic_buffer_resource arena;
+	 *  auto even = foo::filteredAs<std::pmr::vector<int>>(numbers, is_even, &arena);
+	 */
+	template <typename OutputContainer, typename Container, typename Filter, typename Allocator,
+			  typename = std::enable_if_t<!execution::IsExecutionPolicy_v<Container>>>
+	auto filteredAs(const Container& container, Filter filter, const Allocator& allocator)
+	{
+		OutputContainer filtered_elements(allocator);
+		filtered_into(container, filtered_elements, filter);
+
+		return filtered_elements;
+	}
+
+	/**
+	 * Filters a temporary Container<InputType> based on Filter function
+	 *
+	 * The elements are compacted in place and the same buffer is returned, i.e. no allocation takes place.
+	 * Elements which cannot be move-assigned are copied by filtered(const Container&, Filter) instead.
+	 */
+	template <typename Container, typename Filter,
+			  std::enable_if_t<!std::is_reference_v<Container> && !std::is_const_v<Container> && traits::IsOwningContainer_v<Container>
+							   && std::is_move_assignable_v<traits::ValueTypeOf<Container>>, int> = 0>
+	Container filtered(Container&& container, Filter filter)
+	{
+		container.erase(std::remove_if(container.begin(), container.end(), [&filter](const auto& element)
+		{
+			return !filter(element);
+		}), container.end());
+
+		return std::move(container);
+	}
+
+	/**
+	 * Filters a temporary Container<InputType> based on Filter function, moving the matching elements into OutputContainer
+	 */
+	template <typename OutputContainer, typename Container, typename Filter,
+			  std::enable_if_t<!std::is_reference_v<Container> && !std::is_const_v<Container> && traits::IsOwningContainer_v<Container>, int> = 0>
+	auto filteredAs(Container&& container, Filter filter)
+	{
+		if constexpr (std::is_same_v<OutputContainer, Container>)
+		{
+			return filtered(std::move(container), filter);
+		}
+		else
+		{
+			OutputContainer filtered_elements;
+			for (auto& element : container)
+			{
+				if (filter(std::as_const(element)))
+				{
+					filtered_elements.push_back(std::move(element));
+				}
+			}
+
+			return filtered_elements;
+		}
+	}
+
+	/**
+	 * Filters Container<InputType> based on Filter function, splitting the work into chunks according to the execution \a policy
+	 *
+	 * @note The relative order of the elements is preserved. \a filter must be safe to call concurrently.
+	 */
+	template <typename Container, typename Filter, typename OutputContainer = Container, typename Policy,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	OutputContainer filtered(Policy policy, const Container& container, Filter filter)
+	{
+		using ValueType = traits::ValueTypeOf<const Container&>;
+
+		auto chunks = detail::for_each_chunk(policy, std::begin(container), static_cast<size_t>(std::size(container)),
+											 [&filter](auto first, auto last, size_t)
+		{
+			std::vector<ValueType> chunk_elements;
+			std::copy_if(first, last, std::back_inserter(chunk_elements), filter);
+			return chunk_elements;
+		});
+
+		OutputContainer filtered_elements;
+		if constexpr (traits::IsReservable_v<OutputContainer>)
+		{
+			using SizeType = decltype(std::declval<OutputContainer>().size());
+
+			size_t size = 0;
+			for (const auto& chunk_elements : chunks)
+			{
+				size += chunk_elements.size();
+			}
+			filtered_elements.reserve(static_cast<SizeType>(size));
+		}
+		for (auto& chunk_elements : chunks)
+		{
+			std::move(chunk_elements.begin(), chunk_elements.end(), std::back_inserter(filtered_elements));
+		}
+
+		return filtered_elements;
+	}
+
+	/**
+	 * Parallel version of filteredAs(), @see filtered(Policy, const Container&, Filter)
+	 */
+	template <typename OutputContainer, typename Policy, typename Container, typename Filter,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto filteredAs(Policy policy, const Container& container, Filter filter)
+	{
+		return filtered<Container, Filter, OutputContainer>(policy, container, filter);
+	}
 }
@@ -1,13 +1,102 @@
 #pragma once
 
+#include "Execution.h"
+#include "Simd.h"
 #include "TypeTraits.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <iterator>
 #include <optional>
 
 namespace foo
 {
+	namespace detail
+	{
+		/**
+		 * Elements of a temporary Container can be moved out of it, unless it is a view of someone else's elements (e.g. boost::iterator_range)
+		 */
+		template <typename Container>
+		constexpr bool CanMoveElementsOut_v = !std::is_reference_v<Container> && !std::is_const_v<Container> && traits::IsOwningContainer_v<Container>;
+
+		/**
+		 * The \a container as it should be searched - implicitly shared (Qt) containers as const, as their non-const begin()
+		 * would detach them, i.e. deep copy the elements whenever the data is shared
+		 */
+		template <typename Container>
+		decltype(auto) searchable(Container& container)
+		{
+			if constexpr (traits::IsImplicitlyShared_v<Container>)
+			{
+				return std::as_const(container);
+			}
+			else
+			{
+				return (container);
+			}
+		}
+
+		template <typename Container, typename Element>
+		auto make_found(Element&& element)
+		{
+			if constexpr (CanMoveElementsOut_v<Container>)
+			{
+				return foo::make_optional(std::move(element));
+			}
+			else
+			{
+				return foo::make_optional(element);
+			}
+		}
+	}
+
+	namespace detail
+	{
+		/**
+		 * Invokes a single selector of a chain, forwarding references where it is safe to do so:
+		 * - a reference into an lvalue object is passed on as is (no copy),
+		 * - a result obtained from a temporary object is materialized, as the temporary dies with the full expression.
+		 *
+		 * Selectors not invocable on the (const) object itself get a copy of it, as chained() always did before.
+		 */
+		template <typename Object, typename Selector>
+		decltype(auto) invoke_selector(Object&& object, const Selector& selector)
+		{
+			if constexpr (std::is_invocable_v<const Selector&, Object&&>)
+			{
+				using Result = std::invoke_result_t<const Selector&, Object&&>;
+
+				if constexpr (std::is_lvalue_reference_v<Object> && !std::is_rvalue_reference_v<Result>)
+				{
+					return std::invoke(selector, FWD(object));
+				}
+				else
+				{
+					return std::decay_t<Result>(std::invoke(selector, FWD(object)));
+				}
+			}
+			else
+			{
+				std::decay_t<Object> copy(FWD(object));
+				return std::decay_t<std::invoke_result_t<const Selector&, std::decay_t<Object>&>>(std::invoke(selector, copy));
+			}
+		}
+
+		template <typename Object, typename Selector, typename... Selectors>
+		decltype(auto) invoke_chain(Object&& object, const Selector& selector, const Selectors&... selectors)
+		{
+			if constexpr (sizeof...(Selectors) == 0)
+			{
+				return invoke_selector(FWD(object), selector);
+			}
+			else
+			{
+				return invoke_chain(invoke_selector(FWD(object), selector), selectors...);
+			}
+		}
+	}
+
 	/**
 	 * Combines multiple selectors into one.
 	 *
@@ -15,35 +104,57 @@ namespace foo
 	 *
 	 * @note This Callable will invoke Selectors on the itermediate object in the left-to-right order.
 	 * Such chain can be used to extract multiple nested properties of an object, or in foo::find()
+	 *
+	 * @note Invoked on an lvalue, the chain yields a reference whenever every step does (e.g. nested member pointers),
+	 * so no intermediate object is copied.
 	 */
 	template <typename Selector, typename... Selectors>
 	auto chained(Selector selector, Selectors... selectors)
 	{
-		return [=](auto object)
+		return [=](auto&& object) -> decltype(auto)
 		{
-			if constexpr (sizeof...(Selectors) == 0)
-			{
-				return std::invoke(selector, object);
-			}
-			else
-			{
-				return chained(selectors...)(std::invoke(selector, object));
-			}
+			return detail::invoke_chain(FWD(object), selector, selectors...);
 		};
 	}
 
+	/**
+	 * Finds the first element equal to \a value
+	 *
+	 * @note Uses a vectorized kernel for contiguous containers of int32_t/float searched for a value of the same type
+	 */
 	template <class Container, class ValueType>
 	auto find(Container&& container, const ValueType& value)
 		-> optional<traits::ValueTypeOf<Container>>
 	{
-		auto it = std::find(std::begin(container), std::end(container), value);
-		if (it != std::end(container))
+		using ElementType = traits::ValueTypeOf<Container>;
+
+		if constexpr (traits::IsContiguousContainer_v<Container> && simd::IsVectorizableElement_v<ElementType> && std::is_same_v<ValueType, ElementType>)
 		{
-			return foo::make_optional(*it);
+			// through the searchable() view as well - the non-const data() of a shared Qt container would detach it
+			const auto data = std::data(detail::searchable(container));
+			const auto size = static_cast<size_t>(std::size(container));
+			const auto index = simd::find_equal<ElementType>(data, size, value);
+			if (index != size)
+			{
+				return detail::make_found<Container>(data[index]);
+			}
+			else
+			{
+				return nullopt;
+			}
 		}
 		else
 		{
-			return nullopt;
+			auto& searched = detail::searchable(container);
+			auto it = std::find(std::begin(searched), std::end(searched), value);
+			if (it != std::end(searched))
+			{
+				return detail::make_found<Container>(*it);
+			}
+			else
+			{
+				return nullopt;
+			}
 		}
 	}
 
@@ -59,14 +170,15 @@ namespace foo
 	auto find(Container&& container, Selector selector, const ValueType& value)
 		-> optional<traits::ValueTypeOf<Container>>
 	{
-		auto it = std::find_if(std::begin(container), std::end(container), [&](const auto& element)
+		auto& searched = detail::searchable(container);
+		auto it = std::find_if(std::begin(searched), std::end(searched), [&](const auto& element)
 		{
 			return std::invoke(selector, element) == value;
 		});
 
-		if (it != std::end(container))
+		if (it != std::end(searched))
 		{
-			return foo::make_optional(*it);
+			return detail::make_found<Container>(*it);
 		}
 		else
 		{
@@ -74,10 +186,17 @@ namespace foo
 		}
 	}
 
+	/**
+	 * Heterogenous find returning a reference to the found element
+	 *
+	 * @note Must not be called on a temporary container, as the reference would dangle; use find() which moves the element out instead
+	 */
 	template <class Container, typename Selector, class ValueType>
 	auto find_ref(Container&& container, Selector selector, const ValueType& value)
 		-> optional<std::reference_wrapper<traits::ValueTypeOf<Container>>>
 	{
+		static_assert(!detail::CanMoveElementsOut_v<Container>, "find_ref() on a temporary container would return a dangling reference");
+
 		auto it = std::find_if(std::begin(container), std::end(container), [&](const auto& element)
 		{
 			return std::invoke(selector, element) == value;
@@ -98,10 +217,11 @@ namespace foo
 	auto find_if(Container&& container, UnaryPredicate&& predicate)
 		-> optional<traits::ValueTypeOf<Container>>
 	{
-		auto it = std::find_if(std::begin(container), std::end(container), FWD(predicate));
-		if (it != std::end(container))
+		auto& searched = detail::searchable(container);
+		auto it = std::find_if(std::begin(searched), std::end(searched), FWD(predicate));
+		if (it != std::end(searched))
 		{
-			return foo::make_optional(*it);
+			return detail::make_found<Container>(*it);
 		}
 		else
 		{
@@ -109,4 +229,114 @@ namespace foo
 		}
 	}
 
+	namespace detail
+	{
+		enum class FindMode { First, Any };
+
+		/**
+		 * Scans the \a container in chunks (according to the execution \a policy), all of which stop as soon as
+		 * no element they have yet to visit can change the result:
+		 * - FindMode::First - once a match was found before their current position,
+		 * - FindMode::Any - once any match was found.
+		 *
+		 * @returns position of the match (the first one in the container order for FindMode::First), or the size of the container
+		 */
+		template <FindMode Mode, typename Policy, typename Container, typename UnaryPredicate>
+		size_t parallel_find_position(Policy policy, Container& container, const UnaryPredicate& predicate)
+		{
+			using Iterator = decltype(std::begin(container));
+
+			const auto size = static_cast<size_t>(std::size(container));
+			std::atomic<size_t> found{ size };
+
+			for_each_chunk(policy, std::begin(container), size, [&](Iterator first, Iterator last, size_t offset)
+			{
+				for (auto position = offset; first != last; ++first, ++position)
+				{
+					const auto best = found.load(std::memory_order_relaxed);
+					if (Mode == FindMode::First ? best <= position : best != size)
+					{
+						break;
+					}
+
+					if (std::invoke(predicate, std::as_const(*first)))
+					{
+						auto current = found.load(std::memory_order_relaxed);
+						while (position < current && !found.compare_exchange_weak(current, position, std::memory_order_relaxed))
+						{
+						}
+						break;
+					}
+				}
+				return true;
+			});
+
+			return found.load();
+		}
+
+		template <FindMode Mode, typename Policy, typename Container, typename UnaryPredicate>
+		auto parallel_find_if(Policy policy, Container&& container, const UnaryPredicate& predicate)
+			-> optional<traits::ValueTypeOf<Container>>
+		{
+			auto& searched = searchable(container);
+			const auto position = parallel_find_position<Mode>(policy, searched, predicate);
+			if (position != static_cast<size_t>(std::size(searched)))
+			{
+				return make_found<Container>(*std::next(std::begin(searched), static_cast<std::ptrdiff_t>(position)));
+			}
+			else
+			{
+				return nullopt;
+			}
+		}
+	}
+
+	/**
+	 * Parallel find_if - splits the \a container into chunks (according to the execution \a policy)
+	 * and stops all of them as soon as the result is known
+	 *
+	 * @example:
+	 *  auto error = foo::find_if(foo::execution::par, log, [&](const Record& record) { return regex.match(record.text).hasMatch(); });
+	 *
+	 * @returns the first (in the container order) element satisfying the \a predicate, as the sequential find_if() does
+	 *
+	 * @note \a predicate must be safe to call concurrently. Pays off for large containers or expensive predicates.
+	 * @see find_any_if() when any match will do
+	 */
+	template <class Policy, class Container, class UnaryPredicate,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto find_if(Policy policy, Container&& container, UnaryPredicate&& predicate)
+		-> optional<traits::ValueTypeOf<Container>>
+	{
+		return detail::parallel_find_if<detail::FindMode::First>(policy, FWD(container), predicate);
+	}
+
+	/**
+	 * Parallel find_if returning any element satisfying the \a predicate (not necessarily the first one),
+	 * which lets every worker stop at the very first match found by any of them
+	 */
+	template <class Policy, class Container, class UnaryPredicate,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto find_any_if(Policy policy, Container&& container, UnaryPredicate&& predicate)
+		-> optional<traits::ValueTypeOf<Container>>
+	{
+		return detail::parallel_find_if<detail::FindMode::Any>(policy, FWD(container), predicate);
+	}
+
+	/**
+	 * Parallel heterogenous find, @see find_if(Policy, Container&&, UnaryPredicate&&)
+	 *
+	 * @example:
+	 *  auto record = foo::find(foo::execution::par, records, &Record::name, "some string");
+	 */
+	template <class Policy, class Container, typename Selector, class ValueType,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto find(Policy policy, Container&& container, Selector selector, const ValueType& value)
+		-> optional<traits::ValueTypeOf<Container>>
+	{
+		return detail::parallel_find_if<detail::FindMode::First>(policy, FWD(container), [&](const auto& element)
+		{
+			return std::invoke(selector, element) == value;
+		});
+	}
 }
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Execution.h"
+#include "Find.h"
+#include "TypeTraits.h"
+
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace foo
+{
+	namespace detail
+	{
+		/**
+		 * Maps every distinct key to a slot, so that duplicated keys are looked up once
+		 */
+		template <typename Key>
+		struct KeySlots
+		{
+			template <typename Keys>
+			explicit KeySlots(const Keys& keys)
+			{
+				mSlots.reserve(static_cast<size_t>(std::size(keys)));
+				mKeySlots.reserve(static_cast<size_t>(std::size(keys)));
+				for (const auto& key : keys)
+				{
+					mKeySlots.push_back(mSlots.emplace(Key(key), mSlots.size()).first->second);
+				}
+			}
+
+			std::unordered_map<Key, size_t>	mSlots;
+			std::vector<size_t>				mKeySlots;
+		};
+
+		/**
+		 * Single pass over the \a container, remembering the first element matching each slot
+		 *
+		 * @returns per slot: iterator to the first match, if any
+		 */
+		template <typename Policy, typename Container, typename Selector, typename Key>
+		auto first_matches(Policy policy, Container& container, const Selector& selector, const KeySlots<Key>& slots)
+		{
+			using Iterator = decltype(std::begin(container));
+
+			auto chunks = for_each_chunk(policy, std::begin(container), static_cast<size_t>(std::size(container)),
+										 [&](Iterator first, Iterator last, size_t)
+			{
+				std::vector<std::optional<Iterator>> matches(slots.mSlots.size());
+				size_t remaining = matches.size();
+
+				for (auto it = first; it != last && remaining != 0; ++it)
+				{
+					const auto slot = slots.mSlots.find(std::invoke(selector, std::as_const(*it)));
+					if (slot != slots.mSlots.end() && !matches[slot->second])
+					{
+						matches[slot->second] = it;
+						--remaining;
+					}
+				}
+				return matches;
+			});
+
+			// the chunks are in the container order, so the first chunk having a match has the first match
+			auto matches = std::move(chunks.front());
+			for (auto chunk = std::next(chunks.begin()); chunk != chunks.end(); ++chunk)
+			{
+				for (size_t slot = 0; slot < matches.size(); ++slot)
+				{
+					if (!matches[slot])
+					{
+						matches[slot] = (*chunk)[slot];
+					}
+				}
+			}
+			return matches;
+		}
+
+		template <typename Container, typename Selector>
+		using ProjectedKey = std::decay_t<std::invoke_result_t<const Selector&, const traits::ValueTypeOf<Container>&>>;
+	}
+
+	/**
+	 * Batch heterogenous find - resolves all \a keys against the \a container in a single pass
+	 * (instead of one foo::find(container, selector, key) per key), split into chunks according to the execution \a policy
+	 *
+	 * @example:
+	 *  auto objects = find_many(container, &QObject::objectName, QStringList{ "one", "two" });
+	 *  auto records = find_many(foo::execution::par, huge_container, &Record::id, ids);
+	 *
+	 * @returns vector of optional<value_type of the Container> - the first match of each key, in the \a keys order
+	 *
+	 * @note With a parallel \a policy, \a selector must be safe to call concurrently
+	 */
+	template <class Policy, class Container, typename Selector, class Keys,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto find_many(Policy policy, Container&& container, Selector selector, const Keys& keys)
+		-> std::vector<optional<traits::ValueTypeOf<Container>>>
+	{
+		const detail::KeySlots<detail::ProjectedKey<Container, Selector>> slots(keys);
+		const auto matches = detail::first_matches(policy, container, selector, slots);
+
+		std::vector<optional<traits::ValueTypeOf<Container>>> found;
+		found.reserve(slots.mKeySlots.size());
+		for (auto slot : slots.mKeySlots)
+		{
+			if (matches[slot])
+			{
+				found.push_back(foo::make_optional(**matches[slot]));
+			}
+			else
+			{
+				found.push_back(nullopt);
+			}
+		}
+		return found;
+	}
+
+	template <class Container, typename Selector, class Keys>
+	auto find_many(Container&& container, Selector selector, const Keys& keys)
+		-> std::vector<optional<traits::ValueTypeOf<Container>>>
+	{
+		return find_many(execution::seq, FWD(container), std::move(selector), keys);
+	}
+
+	/**
+	 * Batch heterogenous find returning references to the found elements, @see find_many()
+	 */
+	template <class Policy, class Container, typename Selector, class Keys,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto find_many_ref(Policy policy, Container&& container, Selector selector, const Keys& keys)
+		-> std::vector<optional<std::reference_wrapper<traits::ValueTypeOf<Container>>>>
+	{
+		static_assert(!detail::CanMoveElementsOut_v<Container>, "find_many_ref() on a temporary container would return dangling references");
+
+		const detail::KeySlots<detail::ProjectedKey<Container, Selector>> slots(keys);
+		const auto matches = detail::first_matches(policy, container, selector, slots);
+
+		std::vector<optional<std::reference_wrapper<traits::ValueTypeOf<Container>>>> found;
+		found.reserve(slots.mKeySlots.size());
+		for (auto slot : slots.mKeySlots)
+		{
+			if (matches[slot])
+			{
+				found.push_back(foo::make_optional(std::ref(**matches[slot])));
+			}
+			else
+			{
+				found.push_back(nullopt);
+			}
+		}
+		return found;
+	}
+
+	template <class Container, typename Selector, class Keys>
+	auto find_many_ref(Container&& container, Selector selector, const Keys& keys)
+		-> std::vector<optional<std::reference_wrapper<traits::ValueTypeOf<Container>>>>
+	{
+		return find_many_ref(execution::seq, FWD(container), std::move(selector), keys);
+	}
+}
@@ -1,8 +1,14 @@
 #include <Foo/External/catch.hpp>
 
+#include <Foo/Core/FindMany.h>
+#include <Foo/Core/Index.h>
 #include <Foo/Core/OptionalAlgorithm.h>
+#include <Foo/Core/SearchView.h>
+#include <Foo/Core/Sorted.h>
 #include <Foo/Models/TypedObjectListModel.h>
 
+#include <QVector>
+
 #include <boost/range.hpp>
 
 namespace
@@ -21,6 +27,45 @@ TEST_CASE("find")
 	CHECK(!maybe_object.has_value());
 }
 
+TEST_CASE("vectorized find")
+{
+	SECTION("finds every position, also in the scalar tail, for the sizes around the vector widths")
+	{
+		for (int size = 0; size <= 40; ++size)
+		{
+			std::vector<int> numbers(size);
+			std::vector<float> reals(size);
+			for (int i = 0; i < size; ++i)
+			{
+				numbers[i] = i;
+				reals[i] = i * 0.5f;
+			}
+
+			for (int i = 0; i < size; ++i)
+			{
+				CHECK(*foo::find(numbers, i) == i);
+				CHECK(*foo::find(reals, i * 0.5f) == i * 0.5f);
+			}
+			CHECK(!foo::find(numbers, -1).has_value());
+			CHECK(!foo::find(reals, -1.0f).has_value());
+		}
+	}
+
+	SECTION("does not detach a shared Qt container")
+	{
+		QVector<int> numbers{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+		QVector<float> reals{ 0.5f, 1.0f, 1.5f, 2.0f, 2.5f, 3.0f, 3.5f, 4.0f, 4.5f };
+		const auto numbers_copy = numbers;
+		const auto reals_copy = reals;
+
+		CHECK(*foo::find(numbers, 7) == 7);
+		CHECK(*foo::find(reals, 3.5f) == 3.5f);
+
+		CHECK(numbers.constData() == numbers_copy.constData());
+		CHECK(reals.constData() == reals_copy.constData());
+	}
+}
+
 TEST_CASE("heterogenous find")
 {
 	SECTION("basic usage")
@@ -41,6 +86,21 @@ TEST_CASE("heterogenous find")
 	}
 }
 
+TEST_CASE("find in a temporary container")
+{
+	SECTION("moves the found element out")
+	{
+		std::vector<std::unique_ptr<int>> numbers;
+		numbers.push_back(std::make_unique<int>(1));
+		numbers.push_back(std::make_unique<int>(2));
+
+		auto maybe_two = foo::find_if(std::move(numbers), [](const auto& number) { return *number == 2; });
+
+		REQUIRE(maybe_two.has_value());
+		CHECK(*maybe_two.value() == 2);
+	}
+}
+
 SCENARIO("foo::find with boost::range")
 {
 	GIVEN("A list of objects")
@@ -106,6 +166,164 @@ SCENARIO("foo::find with boost::range")
 	}
 }
 
+TEST_CASE("find_many")
+{
+	struct Element { QString name; int id; };
+	std::vector<Element> elements;
+	for (int id = 0; id < 10000; ++id)
+	{
+		elements.push_back({ QString::number(id % 1000), id });
+	}
+	const QStringList keys{ "7", "missing", "999", "7" };
+
+	SECTION("returns the first match of every key, in the keys order")
+	{
+		auto found = foo::find_many(elements, &Element::name, keys);
+
+		REQUIRE(found.size() == 4);
+		CHECK(found[0]->id == 7);
+		CHECK(!found[1].has_value());
+		CHECK(found[2]->id == 999);
+		CHECK(found[3]->id == 7);
+	}
+
+	SECTION("the parallel variant gives the same results")
+	{
+		auto found = foo::find_many(foo::execution::par, elements, &Element::name, keys);
+
+		REQUIRE(found.size() == 4);
+		CHECK(found[0]->id == 7);
+		CHECK(!found[1].has_value());
+		CHECK(found[2]->id == 999);
+	}
+
+	SECTION("references to the elements can be obtained")
+	{
+		auto found = foo::find_many_ref(elements, &Element::name, QStringList{ "3" });
+
+		REQUIRE(found.front().has_value());
+		CHECK(&found.front()->get() == &elements[3]);
+	}
+}
+
+TEST_CASE("parallel find_if")
+{
+	struct Element { QString name; int id; };
+	std::vector<Element> elements;
+	for (int id = 0; id < 100000; ++id)
+	{
+		elements.push_back({ QString::number(id % 1000), id });
+	}
+
+	SECTION("returns the first match in the container order")
+	{
+		auto found = foo::find_if(foo::execution::par, elements, [](const Element& element) { return element.id % 30000 == 29999; });
+
+		REQUIRE(found.has_value());
+		CHECK(found->id == 29999);
+	}
+
+	SECTION("finds any match when the order does not matter")
+	{
+		auto found = foo::find_any_if(foo::execution::par, elements, [](const Element& element) { return element.name == "42"; });
+
+		REQUIRE(found.has_value());
+		CHECK(found->id % 1000 == 42);
+	}
+
+	SECTION("heterogenous find")
+	{
+		CHECK(foo::find(foo::execution::par, elements, &Element::name, QString("999"))->id == 999);
+		CHECK(!foo::find(foo::execution::par, elements, &Element::name, QString("missing")).has_value());
+	}
+}
+
+SCENARIO("foo::Index answers repeated heterogenous finds")
+{
+	GIVEN("a container indexed by a member")
+	{
+		struct Element { QString name; int id; };
+		std::vector<Element> elements{ {"one", 1}, {"two", 2}, {"one", 3} };
+
+		auto by_name = foo::make_index(elements, &Element::name);
+
+		THEN("lookups agree with foo::find")
+		{
+			CHECK(by_name.find("one")->id == foo::find(elements, &Element::name, "one")->id);
+			CHECK(!by_name.find("three").has_value());
+			REQUIRE(by_name.find_all("one").size() == 2);
+			CHECK(by_name.find_all("one")[1].get().id == 3);
+		}
+		WHEN("elements are appended to the built index")
+		{
+			// builds the index, so that appended() indexes only the new elements
+			REQUIRE(!by_name.contains("three"));
+
+			elements.push_back({"three", 4});
+			by_name.appended();
+
+			THEN("they can be found, and so can the earlier ones")
+			{
+				REQUIRE(by_name.find_ref("three").has_value());
+				CHECK(by_name.find_ref("three")->get().id == 4);
+				CHECK(by_name.find_all("one").size() == 2);
+			}
+		}
+		WHEN("elements are modified and the index is invalidated")
+		{
+			elements.front().name = "zero";
+			by_name.invalidate();
+
+			THEN("the lookups reflect the change")
+			{
+				CHECK(by_name.find("one")->id == 3);
+				CHECK(by_name.contains("zero"));
+			}
+		}
+	}
+}
+
+SCENARIO("searching in sorted containers")
+{
+	GIVEN("a container sorted by a member")
+	{
+		struct Element { int id; QString name; };
+		std::vector<Element> elements{ {1, "one"}, {3, "three"}, {3, "three again"}, {7, "seven"} };
+
+		THEN("find_sorted() and the bound functions agree with foo::find")
+		{
+			for (int id = 0; id < 9; ++id)
+			{
+				CHECK(foo::find_sorted(elements, &Element::id, id).has_value() == foo::find(elements, &Element::id, id).has_value());
+			}
+
+			CHECK(foo::lower_bound_by(elements, &Element::id, 2)->id == 3);
+			CHECK(foo::upper_bound_by(elements, &Element::id, 3)->id == 7);
+
+			auto [first, last] = foo::equal_range_by(elements, &Element::id, 3);
+			CHECK(std::distance(first, last) == 2);
+		}
+		THEN("the search view finds the same elements")
+		{
+			auto view = foo::make_search_view(elements, &Element::id);
+
+			for (int id = 0; id < 9; ++id)
+			{
+				const auto expected = foo::find_sorted(elements, &Element::id, id);
+				const auto found = view.find(id);
+
+				REQUIRE(found.has_value() == expected.has_value());
+				if (found)
+				{
+					CHECK(found->name == expected->name);
+				}
+			}
+			CHECK(view.lower_bound(4) == 3);
+			CHECK(view.lower_bound(8) == view.size());
+		}
+	}
+}
+
 SCENARIO("foo::chained() combines selectors")
 {
 	GIVEN("an object with nested properties")
@@ -133,6 +351,57 @@ SCENARIO("foo::chained() combines selectors")
 			}
 		}
 	}
+
+	GIVEN("an object with nested members, which count their copies")
+	{
+		static int copies = 0;
+		struct Counted
+		{
+			Counted() = default;
+			Counted(const Counted& other) : value(other.value) { ++copies; }
+			int value = 42;
+		};
+		struct Middle { Counted counted; const Counted& get() const { return counted; } };
+		struct Outer { Middle middle; };
+
+		Outer object;
+		copies = 0;
+
+		WHEN("member pointers are chained")
+		{
+			auto value_selector = foo::chained(&Outer::middle, &Middle::counted, &Counted::value);
+
+			THEN("the chain yields a reference and nothing is copied")
+			{
+				static_assert(std::is_same_v<decltype(value_selector(object)), int&>);
+				value_selector(object) = 7;
+
+				CHECK(object.middle.counted.value == 7);
+				CHECK(std::as_const(value_selector)(std::as_const(object)) == 7);
+				CHECK(copies == 0);
+			}
+		}
+		WHEN("a getter returning a reference is chained")
+		{
+			auto counted_selector = foo::chained(&Outer::middle, &Middle::get);
+
+			THEN("the reference is passed through")
+			{
+				CHECK(&counted_selector(std::as_const(object)) == &object.middle.counted);
+				CHECK(copies == 0);
+			}
+		}
+		WHEN("the chain is invoked on a temporary")
+		{
+			auto value_selector = foo::chained(&Outer::middle, &Middle::counted, &Counted::value);
+
+			THEN("the result is materialized instead of dangling")
+			{
+				static_assert(std::is_same_v<decltype(value_selector(Outer{})), int>);
+				CHECK(value_selector(Outer{}) == 42);
+			}
+		}
+	}
 }
 
 #include "OptionalAlgorithm_test.moc"
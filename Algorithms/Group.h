@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Execution.h"
+#include "TypeTraits.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace foo
+{
+	/**
+	 * Open addressing (linear probing) hash map, which keeps its entries densely packed in the insertion order
+	 *
+	 * The entries live in a single std::vector, and the hash table is just an array of positions into it,
+	 * so lookups touch at most a couple of cache lines and iteration is a plain vector walk.
+	 * Elements can not be erased - the map is meant to be built and then read, e.g. by grouped_by()/aggregated_by().
+	 *
+	 * @example:
+	 *  for (const auto& [city, records] : foo::grouped_by(records, &Record::city))
+	 *  {
+	 *      qDebug() << city << records.size();
+	 *  }
+	 */
+	template <typename Key,
+			  typename Value,
+			  typename Hash = std::hash<Key>,
+			  typename KeyEqual = std::equal_to<Key>
+			  >
+	class FlatHashMap
+	{
+	public:
+		using KeyType			= Key;
+		using MappedType		= Value;
+		using Entry				= std::pair<Key, Value>;
+		using iterator			= typename std::vector<Entry>::iterator;
+		using const_iterator	= typename std::vector<Entry>::const_iterator;
+
+		FlatHashMap() = default;
+
+		explicit FlatHashMap(size_t expected_size)
+		{
+			reserve(expected_size);
+		}
+
+		/**
+		 * Inserts Value constructed from \a args under the \a key, unless the \a key is already present
+		 *
+		 * @returns iterator to the entry with the \a key, and whether it was inserted
+		 */
+		template <typename KeyArg, typename... Args>
+		std::pair<iterator, bool> try_emplace(KeyArg&& key, Args&&... args)
+		{
+			const size_t hash = Hash{}(key);
+			return try_emplace_hashed(hash, std::forward<KeyArg>(key), std::forward<Args>(args)...);
+		}
+
+		auto find(const Key& key) -> optional<std::reference_wrapper<Value>>
+		{
+			const auto position = find_position(Hash{}(key), key);
+			if (position != NOT_FOUND)
+			{
+				return foo::make_optional(std::ref(mEntries[position].second));
+			}
+			else
+			{
+				return nullopt;
+			}
+		}
+
+		auto find(const Key& key) const -> optional<std::reference_wrapper<const Value>>
+		{
+			const auto position = find_position(Hash{}(key), key);
+			if (position != NOT_FOUND)
+			{
+				return foo::make_optional(std::cref(mEntries[position].second));
+			}
+			else
+			{
+				return nullopt;
+			}
+		}
+
+		bool contains(const Key& key) const
+		{
+			return find_position(Hash{}(key), key) != NOT_FOUND;
+		}
+
+		/**
+		 * Moves the entries of \a other into this map (keeping their order after the already present ones),
+		 * calling \a merger(Value& value, Value&& other_value) for the keys present in both
+		 */
+		template <typename Merger>
+		void merge(FlatHashMap&& other, Merger&& merger)
+		{
+			reserve(size() + other.size());
+			for (size_t position = 0; position < other.mEntries.size(); ++position)
+			{
+				auto& entry = other.mEntries[position];
+				auto [it, inserted] = try_emplace_hashed(other.mHashes[position], std::move(entry.first), std::move(entry.second));
+				if (!inserted)
+				{
+					std::invoke(merger, it->second, std::move(entry.second));
+				}
+			}
+			other = FlatHashMap{};
+		}
+
+		void reserve(size_t size)
+		{
+			mEntries.reserve(size);
+			mHashes.reserve(size);
+			if (!fits(size))
+			{
+				size_t capacity = MIN_CAPACITY;
+				while (size * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR)
+				{
+					capacity *= 2;
+				}
+				rehash(capacity);
+			}
+		}
+
+		size_t size() const { return mEntries.size(); }
+		bool empty() const { return mEntries.empty(); }
+
+		iterator begin() { return mEntries.begin(); }
+		iterator end() { return mEntries.end(); }
+		const_iterator begin() const { return mEntries.begin(); }
+		const_iterator end() const { return mEntries.end(); }
+
+	private:
+		static constexpr size_t NOT_FOUND				= static_cast<size_t>(-1);
+		static constexpr size_t EMPTY_SLOT				= 0;
+		static constexpr size_t MIN_CAPACITY			= 16;
+		static constexpr size_t MAX_LOAD_NUMERATOR		= 3;
+		static constexpr size_t MAX_LOAD_DENOMINATOR	= 4;
+
+		template <typename KeyArg, typename... Args>
+		std::pair<iterator, bool> try_emplace_hashed(size_t hash, KeyArg&& key, Args&&... args)
+		{
+			if (!fits(mEntries.size() + 1))
+			{
+				rehash(std::max(MIN_CAPACITY, mSlots.size() * 2));
+			}
+
+			auto slot = first_slot(hash);
+			while (mSlots[slot] != EMPTY_SLOT)
+			{
+				const auto position = mSlots[slot] - 1;
+				if (mHashes[position] == hash && KeyEqual{}(mEntries[position].first, key))
+				{
+					return { mEntries.begin() + static_cast<std::ptrdiff_t>(position), false };
+				}
+				slot = (slot + 1) & (mSlots.size() - 1);
+			}
+
+			mEntries.emplace_back(std::piecewise_construct,
+								  std::forward_as_tuple(std::forward<KeyArg>(key)),
+								  std::forward_as_tuple(std::forward<Args>(args)...));
+			mHashes.push_back(hash);
+			mSlots[slot] = mEntries.size();
+			return { std::prev(mEntries.end()), true };
+		}
+
+		size_t find_position(size_t hash, const Key& key) const
+		{
+			if (mSlots.empty())
+			{
+				return NOT_FOUND;
+			}
+
+			for (auto slot = first_slot(hash); mSlots[slot] != EMPTY_SLOT; slot = (slot + 1) & (mSlots.size() - 1))
+			{
+				const auto position = mSlots[slot] - 1;
+				if (mHashes[position] == hash && KeyEqual{}(mEntries[position].first, key))
+				{
+					return position;
+				}
+			}
+			return NOT_FOUND;
+		}
+
+		/** Fibonacci hashing - spreads even the identity hashes of integers (std::hash<int>) over the whole table */
+		size_t first_slot(size_t hash) const
+		{
+			return static_cast<size_t>((static_cast<std::uint64_t>(hash) * 11400714819323198485ull) >> mShift);
+		}
+
+		bool fits(size_t size) const
+		{
+			return size * MAX_LOAD_DENOMINATOR <= mSlots.size() * MAX_LOAD_NUMERATOR;
+		}
+
+		void rehash(size_t capacity)
+		{
+			mSlots.assign(capacity, EMPTY_SLOT);
+			mShift = 64;
+			for (size_t bits = capacity; bits > 1; bits /= 2)
+			{
+				--mShift;
+			}
+
+			for (size_t position = 0; position < mHashes.size(); ++position)
+			{
+				auto slot = first_slot(mHashes[position]);
+				while (mSlots[slot] != EMPTY_SLOT)
+				{
+					slot = (slot + 1) & (capacity - 1);
+				}
+				mSlots[slot] = position + 1;
+			}
+		}
+
+		std::vector<Entry>	mEntries;
+		std::vector<size_t>	mHashes;
+		std::vector<size_t>	mSlots;		// position in mEntries + 1, or EMPTY_SLOT
+		unsigned			mShift = 64;
+	};
+
+	namespace detail
+	{
+		template <typename Container, typename Selector>
+		using GroupKey_t = std::decay_t<std::invoke_result_t<const Selector&, const traits::ValueTypeOf<Container>&>>;
+
+		/** Groups are of the same type as the grouped container, as in filtered(), unless it does not own its elements */
+		template <typename Container>
+		using Group_t = std::conditional_t<traits::IsOwningContainer_v<std::decay_t<Container>>, std::decay_t<Container>, std::vector<traits::ValueTypeOf<Container>>>;
+
+		template <typename Container, typename Selector, typename Iterator>
+		auto group_range(Iterator first, Iterator last, const Selector& selector)
+		{
+			FlatHashMap<GroupKey_t<Container, Selector>, Group_t<Container>> groups;
+			for (; first != last; ++first)
+			{
+				groups.try_emplace(std::invoke(selector, *first)).first->second.push_back(*first);
+			}
+			return groups;
+		}
+
+		template <typename Container, typename Selector, typename Accumulator, typename Iterator, typename Reducer>
+		auto aggregate_range(Iterator first, Iterator last, const Selector& selector, const Accumulator& init, Reducer& reducer)
+		{
+			FlatHashMap<GroupKey_t<Container, Selector>, Accumulator> aggregates;
+			for (; first != last; ++first)
+			{
+				auto& accumulator = aggregates.try_emplace(std::invoke(selector, *first), init).first->second;
+				accumulator = std::invoke(reducer, std::move(accumulator), *first);
+			}
+			return aggregates;
+		}
+
+		/**
+		 * Builds a partial table per chunk (according to the execution \a policy) and merges them in the chunk order,
+		 * so the result is the same as the sequential one
+		 */
+		template <typename Policy, typename Container, typename BuildTable, typename Merger>
+		auto build_partitioned(Policy policy, const Container& container, BuildTable&& build_table, Merger&& merger)
+		{
+			auto tables = for_each_chunk(policy, std::begin(container), static_cast<size_t>(std::size(container)), [&](auto first, auto last, size_t)
+			{
+				return build_table(first, last);
+			});
+
+			auto result = std::move(tables.front());
+			for (auto table = std::next(tables.begin()); table != tables.end(); ++table)
+			{
+				result.merge(std::move(*table), merger);
+			}
+			return result;
+		}
+	}
+
+	/**
+	 * Groups the elements of \a container by the property obtainable via \a selector (a member pointer, a getter or foo::chained())
+	 *
+	 * @example:
+	 *  auto by_city = foo::grouped_by(records, foo::chained(&Record::address, &Address::city));
+	 *  auto prague = by_city.find("Prague");
+	 *
+	 * @returns FlatHashMap from the property to the group of elements - the groups are in the order in which their
+	 * first element appears in the \a container, the elements keep their relative order
+	 */
+	template <class Container, typename Selector>
+	auto grouped_by(const Container& container, Selector selector)
+	{
+		return detail::group_range<const Container&>(std::begin(container), std::end(container), selector);
+	}
+
+	/**
+	 * Parallel grouped_by() - groups each chunk (according to the execution \a policy) separately and merges the partial groups
+	 *
+	 * @note The result is the same as of the sequential version. \a selector must be safe to call concurrently
+	 */
+	template <class Policy, class Container, typename Selector,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto grouped_by(Policy policy, const Container& container, Selector selector)
+	{
+		return detail::build_partitioned(policy, container,
+		[&](auto first, auto last)
+		{
+			return detail::group_range<const Container&>(first, last, selector);
+		},
+		[](auto& group, auto&& other_group)
+		{
+			std::move(std::begin(other_group), std::end(other_group), std::back_inserter(group));
+		});
+	}
+
+	/**
+	 * Reduces the elements of \a container grouped by the property obtainable via \a selector
+	 *
+	 * Each group starts with a copy of \a init, which is then replaced by \a reducer(std::move(accumulator), element)
+	 * for each of the group's elements - i.e. it is a std::accumulate() per group.
+	 *
+	 * @example:
+	 *  auto revenue_per_customer = foo::aggregated_by(orders, &Order::customer, 0.0, [](double sum, const Order& order) { return sum + order.price; });
+	 *
+	 * @returns FlatHashMap from the property to the accumulated value, in the order of the first appearance
+	 */
+	template <class Container, typename Selector, typename Accumulator, typename Reducer>
+	auto aggregated_by(const Container& container, Selector selector, Accumulator init, Reducer reducer)
+	{
+		return detail::aggregate_range<const Container&>(std::begin(container), std::end(container), selector, init, reducer);
+	}
+
+	/**
+	 * Parallel aggregated_by() - aggregates each chunk (according to the execution \a policy) separately and combines
+	 * the partial accumulators of the same group by \a merger(std::move(accumulator), std::move(other_accumulator))
+	 *
+	 * Each chunk starts its groups with a copy of \a init, so \a init must be the identity of \a merger (e.g. 0 for
+	 * std::plus, 1 for std::multiplies) - or the result would count it once per chunk. For other initial values use
+	 * the overload taking the \a identity separately.
+	 *
+	 * @example:
+	 *  auto revenue_per_customer = foo::aggregated_by(foo::execution::par, orders, &Order::customer, 0.0,
+	 *                                                 [](double sum, const Order& order) { return sum + order.price; },
+	 *                                                 std::plus<>{});
+	 *
+	 * @note \a selector, \a reducer and \a merger must be safe to call concurrently
+	 */
+	template <class Policy, class Container, typename Selector, typename Accumulator, typename Reducer, typename Merger,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto aggregated_by(Policy policy, const Container& container, Selector selector, Accumulator init, Reducer reducer, Merger merger)
+	{
+		if constexpr (traits::IsCallable_v<std::equal_to<>, const Accumulator&, const Accumulator&>)
+		{
+			assert(std::invoke(merger, Accumulator(init), Accumulator(init)) == init && "init must be the identity of merger");
+		}
+
+		return detail::build_partitioned(policy, container,
+		[&](auto first, auto last)
+		{
+			return detail::aggregate_range<const Container&>(first, last, selector, init, reducer);
+		},
+		[&](Accumulator& accumulator, Accumulator&& other_accumulator)
+		{
+			accumulator = std::invoke(merger, std::move(accumulator), std::move(other_accumulator));
+		});
+	}
+
+	/**
+	 * Parallel aggregated_by() starting from any \a init - the chunks start their groups from the \a identity of \a merger,
+	 * and \a init is merged into each group once, at the end
+	 *
+	 * @example:
+	 *  auto stock = foo::aggregated_by(foo::execution::par, movements, &Movement::item, initial_stock, 0,
+	 *                                  [](int count, const Movement& movement) { return count + movement.delta; },
+	 *                                  std::plus<>{});
+	 */
+	template <class Policy, class Container, typename Selector, typename Accumulator, typename Reducer, typename Merger,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto aggregated_by(Policy policy, const Container& container, Selector selector, Accumulator init, Accumulator identity, Reducer reducer, Merger merger)
+	{
+		auto aggregates = aggregated_by(policy, container, selector, std::move(identity), reducer, merger);
+		for (auto& entry : aggregates)
+		{
+			entry.second = std::invoke(merger, Accumulator(init), std::move(entry.second));
+		}
+		return aggregates;
+	}
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "TypeTraits.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace foo
+{
+	/**
+	 * Hash index over the property of the \a container's elements (obtainable via \a selector)
+	 *
+	 * Answers the same questions as the heterogenous foo::find()/find_ref() in O(1), instead of a linear scan,
+	 * so it pays off when the same container is searched repeatedly.
+	 *
+	 * @example:
+	 *  auto by_name = foo::make_index(items, &QObject::objectName);
+	 *  for (const auto& name : names)
+	 *  {
+	 *      auto item = by_name.find(name);		// instead of foo::find(items, &QObject::objectName, name)
+	 *  }
+	 *
+	 * @note The index refers to the container and does not observe it. After elements are appended call appended(),
+	 * after any other modification call invalidate() (the index is then rebuilt on the next lookup).
+	 * Lookups may rebuild the index, so an Index must not be shared between threads without synchronization.
+	 */
+	template <typename Container,
+			  typename Selector,
+			  typename Key = std::decay_t<std::invoke_result_t<const Selector&, const traits::ValueTypeOf<Container&>&>>,
+			  typename Hash = std::hash<Key>
+			  >
+	class Index
+	{
+	public:
+		using ValueType		= traits::ValueTypeOf<Container&>;
+		using KeyType		= Key;
+		using ElementType	= std::remove_reference_t<decltype(*std::begin(std::declval<Container&>()))>;
+
+		static_assert(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<decltype(std::begin(std::declval<Container&>()))>::iterator_category>,
+					  "foo::Index requires a random access container");
+
+		Index(Container& container, Selector selector)
+			: mContainer(container)
+			, mSelector(std::move(selector))
+		{
+		}
+
+		/**
+		 * @returns optional<value_type of the Container> - the first (in the container order) element with the given \a key
+		 */
+		auto find(const KeyType& key) const -> optional<ValueType>
+		{
+			const auto position = first_position(key);
+			if (position)
+			{
+				return foo::make_optional(element(*position));
+			}
+			else
+			{
+				return nullopt;
+			}
+		}
+
+		auto find_ref(const KeyType& key) const -> optional<std::reference_wrapper<ElementType>>
+		{
+			const auto position = first_position(key);
+			if (position)
+			{
+				return foo::make_optional(std::ref(element(*position)));
+			}
+			else
+			{
+				return nullopt;
+			}
+		}
+
+		/**
+		 * @returns all elements with the given \a key, in the container order
+		 */
+		auto find_all(const KeyType& key) const -> std::vector<std::reference_wrapper<ElementType>>
+		{
+			ensure_built();
+
+			const auto range = mPositions.equal_range(key);
+
+			std::vector<size_t> positions;
+			std::transform(range.first, range.second, std::back_inserter(positions), [](const auto& entry) { return entry.second; });
+			std::sort(positions.begin(), positions.end());
+
+			std::vector<std::reference_wrapper<ElementType>> elements;
+			elements.reserve(positions.size());
+			for (auto position : positions)
+			{
+				elements.push_back(std::ref(element(position)));
+			}
+			return elements;
+		}
+
+		bool contains(const KeyType& key) const
+		{
+			ensure_built();
+			return mPositions.find(key) != mPositions.end();
+		}
+
+		/**
+		 * Indexes the elements appended to the container since the index was last (re)built
+		 */
+		void appended()
+		{
+			if (mValid)
+			{
+				index_from(mIndexedCount);
+			}
+		}
+
+		/**
+		 * Marks the index as out of date, e.g. after the elements have been modified, inserted or removed
+		 */
+		void invalidate()
+		{
+			mValid = false;
+		}
+
+		void rebuild()
+		{
+			build();
+		}
+
+	private:
+		void build() const
+		{
+			mPositions.clear();
+			mPositions.reserve(static_cast<size_t>(std::size(mContainer)));
+			mIndexedCount = 0;
+			mValid = true;
+
+			index_from(0);
+		}
+
+		void ensure_built() const
+		{
+			// shrinking can never be fixed incrementally
+			if (!mValid || static_cast<size_t>(std::size(mContainer)) < mIndexedCount)
+			{
+				build();
+			}
+		}
+
+		void index_from(size_t first) const
+		{
+			const auto size = static_cast<size_t>(std::size(mContainer));
+			for (size_t position = first; position < size; ++position)
+			{
+				mPositions.emplace(std::invoke(mSelector, std::as_const(element(position))), position);
+			}
+			mIndexedCount = size;
+		}
+
+		std::optional<size_t> first_position(const KeyType& key) const
+		{
+			ensure_built();
+
+			const auto range = mPositions.equal_range(key);
+			if (range.first == range.second)
+			{
+				return std::nullopt;
+			}
+
+			return std::min_element(range.first, range.second, [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; })->second;
+		}
+
+		ElementType& element(size_t position) const
+		{
+			return std::begin(mContainer)[static_cast<std::ptrdiff_t>(position)];
+		}
+
+		Container&										mContainer;
+		Selector										mSelector;
+		mutable std::unordered_multimap<Key, size_t, Hash>	mPositions;
+		mutable size_t									mIndexedCount	= 0;
+		mutable bool									mValid			= false;
+	};
+
+	/**
+	 * Creates an Index of the \a container by the property obtainable via \a selector
+	 */
+	template <typename Container, typename Selector>
+	auto make_index(Container& container, Selector selector)
+	{
+		return Index<Container, Selector>{ container, std::move(selector) };
+	}
+}
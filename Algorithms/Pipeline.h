@@ -0,0 +1,231 @@
+#pragma once
+
+#include "TypeTraits.h"
+
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace foo
+{
+	/**
+	 * Lazy counterparts of filtered() and transformed(), composable with operator|
+	 *
+	 * @example:
+	 *  auto names = objects
+	 *      | foo::filter([](auto object){ return object->isEnabled(); })
+	 *      | foo::transform(&QObject::objectName)
+	 *      | foo::to<QStringList>();
+	 *
+	 * No intermediate containers are created - every element travels through all the stages
+	 * in a single pass, and the only allocation happens in the final sink (foo::to<>()).
+	 */
+	template <typename Filter>
+	struct Filtering
+	{
+		template <typename Input>
+		using Output = Input;
+
+		static constexpr bool PreservesSize = false;
+
+		template <typename Value, typename Next>
+		void apply(Value&& value, Next&& next) const
+		{
+			if (std::invoke(mFilter, std::as_const(value)))
+			{
+				next(FWD(value));
+			}
+		}
+
+		Filter mFilter;
+	};
+
+	template <typename Transform>
+	struct Transforming
+	{
+		template <typename Input>
+		using Output = std::invoke_result_t<const Transform&, Input>;
+
+		static constexpr bool PreservesSize = true;
+
+		template <typename Value, typename Next>
+		void apply(Value&& value, Next&& next) const
+		{
+			next(std::invoke(mTransform, FWD(value)));
+		}
+
+		Transform mTransform;
+	};
+
+	/**
+	 * Sinks terminating a pipeline, @see to()
+	 */
+	template <typename OutputContainer>
+	struct CollectingAs {};
+
+	template <template <typename...> class OutputContainer>
+	struct CollectingInto {};
+
+	/**
+	 * Filters the elements of a pipeline based on Filter function
+	 */
+	template <typename Filter>
+	auto filter(Filter filter)
+	{
+		return Filtering<Filter>{ std::move(filter) };
+	}
+
+	/**
+	 * Transforms the elements of a pipeline based on Transform function
+	 */
+	template <typename Transform>
+	auto transform(Transform transformer)
+	{
+		return Transforming<Transform>{ std::move(transformer) };
+	}
+
+	/**
+	 * Runs the pipeline and collects its elements into OutputContainer
+	 */
+	template <typename OutputContainer>
+	auto to()
+	{
+		return CollectingAs<OutputContainer>{};
+	}
+
+	/**
+	 * Runs the pipeline and collects its elements into OutputContainer<value type of the last stage>
+	 */
+	template <template <typename...> class OutputContainer>
+	auto to()
+	{
+		return CollectingInto<OutputContainer>{};
+	}
+
+	template <typename Range, typename... Stages>
+	class Pipeline;
+
+	namespace detail
+	{
+		template <typename T>
+		struct IsPipelineStage : std::false_type {};
+
+		template <typename Filter>
+		struct IsPipelineStage<Filtering<Filter>> : std::true_type {};
+
+		template <typename Transform>
+		struct IsPipelineStage<Transforming<Transform>> : std::true_type {};
+
+		template <typename T>
+		constexpr bool IsPipelineStage_v = IsPipelineStage<std::decay_t<T>>::value;
+
+		template <typename T>
+		constexpr bool IsPipeline_v = traits::IsSpecializationOf_v<Pipeline, std::decay_t<T>>;
+
+		template <typename Input, typename... Stages>
+		struct PipelineOutput { using Type = Input; };
+
+		template <typename Input, typename Stage, typename... Stages>
+		struct PipelineOutput<Input, Stage, Stages...>
+		{
+			using Type = typename PipelineOutput<typename Stage::template Output<Input>, Stages...>::Type;
+		};
+	}
+
+	/**
+	 * Range (held by reference when it is an lvalue, by value otherwise) together with the stages to be applied to it
+	 */
+	template <typename Range, typename... Stages>
+	class Pipeline
+	{
+	public:
+		using ReferenceType = decltype(*std::begin(std::declval<const std::remove_reference_t<Range>&>()));
+		using ValueType = std::remove_cv_t<std::remove_reference_t<typename detail::PipelineOutput<ReferenceType, Stages...>::Type>>;
+
+		static constexpr bool PreservesSize = (Stages::PreservesSize && ...);
+
+		Pipeline(Range&& range, std::tuple<Stages...> stages)
+			: mRange(std::forward<Range>(range))
+			, mStages(std::move(stages))
+		{
+		}
+
+		template <typename Stage>
+		auto append(Stage stage) &&
+		{
+			return Pipeline<Range, Stages..., Stage>{ std::forward<Range>(mRange), std::tuple_cat(std::move(mStages), std::make_tuple(std::move(stage))) };
+		}
+
+		template <typename Stage>
+		auto append(Stage stage) const &
+		{
+			return Pipeline{ *this }.append(std::move(stage));
+		}
+
+		template <typename OutputContainer>
+		OutputContainer collect() const
+		{
+			OutputContainer output;
+			if constexpr (PreservesSize && traits::HasReserve_v<OutputContainer> && traits::HasSize_v<const std::remove_reference_t<Range>>)
+			{
+				using SizeType = decltype(std::declval<OutputContainer>().size());
+				output.reserve(static_cast<SizeType>(std::size(mRange)));
+			}
+
+			auto inserter = std::back_inserter(output);
+			for (auto&& element : std::as_const(mRange))
+			{
+				push<0>(FWD(element), inserter);
+			}
+
+			return output;
+		}
+
+	private:
+		template <size_t Index, typename Value, typename Consumer>
+		void push(Value&& value, Consumer& consumer) const
+		{
+			if constexpr (Index == sizeof...(Stages))
+			{
+				*consumer = FWD(value);
+			}
+			else
+			{
+				std::get<Index>(mStages).apply(FWD(value), [&](auto&& next_value)
+				{
+					push<Index + 1>(FWD(next_value), consumer);
+				});
+			}
+		}
+
+		Range					mRange;
+		std::tuple<Stages...>	mStages;
+	};
+
+	template <typename Range, typename Stage, typename = std::enable_if_t<detail::IsPipelineStage_v<Stage>>>
+	auto operator|(Range&& range, Stage stage)
+	{
+		if constexpr (detail::IsPipeline_v<Range>)
+		{
+			return FWD(range).append(std::move(stage));
+		}
+		else
+		{
+			return Pipeline<Range, Stage>{ std::forward<Range>(range), std::make_tuple(std::move(stage)) };
+		}
+	}
+
+	template <typename Range, typename... Stages, typename OutputContainer>
+	OutputContainer operator|(const Pipeline<Range, Stages...>& pipeline, CollectingAs<OutputContainer>)
+	{
+		return pipeline.template collect<OutputContainer>();
+	}
+
+	template <typename Range, typename... Stages, template <typename...> class OutputContainer>
+	auto operator|(const Pipeline<Range, Stages...>& pipeline, CollectingInto<OutputContainer>)
+	{
+		return pipeline.template collect<OutputContainer<typename Pipeline<Range, Stages...>::ValueType>>();
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+namespace foo
+{
+	/**
+	 * Comparison predicates usable with filtered(), find_if() etc.
+	 *
+	 * Unlike lambdas, their comparison is known to the algorithms, which can select
+	 * vectorized kernels for them (@see Simd.h).
+	 *
+	 * @example:
+	 *  auto positive = foo::filtered(numbers, foo::greater_than(0));
+	 */
+	template <typename T>
+	struct EqualTo
+	{
+		template <typename U>
+		bool operator()(const U& element) const { return element == value; }
+
+		T value;
+	};
+
+	template <typename T>
+	struct NotEqualTo
+	{
+		template <typename U>
+		bool operator()(const U& element) const { return element != value; }
+
+		T value;
+	};
+
+	template <typename T>
+	struct LessThan
+	{
+		template <typename U>
+		bool operator()(const U& element) const { return element < value; }
+
+		T value;
+	};
+
+	template <typename T>
+	struct GreaterThan
+	{
+		template <typename U>
+		bool operator()(const U& element) const { return element > value; }
+
+		T value;
+	};
+
+	/**
+	 * Closed range [low, high]
+	 */
+	template <typename T>
+	struct InRange
+	{
+		template <typename U>
+		bool operator()(const U& element) const { return low <= element && element <= high; }
+
+		T low;
+		T high;
+	};
+
+	template <typename T>
+	auto equal_to(T value) { return EqualTo<T>{ value }; }
+
+	template <typename T>
+	auto not_equal_to(T value) { return NotEqualTo<T>{ value }; }
+
+	template <typename T>
+	auto less_than(T value) { return LessThan<T>{ value }; }
+
+	template <typename T>
+	auto greater_than(T value) { return GreaterThan<T>{ value }; }
+
+	template <typename T>
+	auto in_range(T low, T high) { return InRange<T>{ low, high }; }
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Predicates.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define FOO_HAS_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define FOO_HAS_SIMD 0
+#endif
+
+/**
+ * Vectorized kernels for find() and filtered() over contiguous int32_t/float data.
+ *
+ * SSE2 is the x86 baseline, AVX2 is selected at runtime when the CPU supports it,
+ * other platforms (and element types/predicates without a kernel) take the scalar path.
+ */
+namespace foo::simd
+{
+	template <typename T>
+	constexpr bool IsVectorizableElement_v = FOO_HAS_SIMD && (std::is_same_v<T, std::int32_t> || std::is_same_v<T, float>);
+
+	template <typename T, typename Predicate>
+	struct IsVectorizablePredicate : std::false_type {};
+
+	template <typename T>
+	struct IsVectorizablePredicate<T, EqualTo<T>> : std::true_type {};
+
+	template <typename T>
+	struct IsVectorizablePredicate<T, NotEqualTo<T>> : std::true_type {};
+
+	template <typename T>
+	struct IsVectorizablePredicate<T, LessThan<T>> : std::true_type {};
+
+	template <typename T>
+	struct IsVectorizablePredicate<T, GreaterThan<T>> : std::true_type {};
+
+	template <typename T>
+	struct IsVectorizablePredicate<T, InRange<T>> : std::true_type {};
+
+	/**
+	 * Whether filtering T elements with Predicate has a vectorized kernel
+	 */
+	template <typename T, typename Predicate>
+	constexpr bool IsVectorizable_v = IsVectorizableElement_v<T> && IsVectorizablePredicate<T, std::decay_t<Predicate>>::value;
+}
+
+#if FOO_HAS_SIMD
+
+namespace foo::simd::detail
+{
+	inline unsigned count_trailing_zeros(unsigned bits)
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return static_cast<unsigned>(index);
+	#else
+		return static_cast<unsigned>(__builtin_ctz(bits));
+	#endif
+	}
+
+	inline unsigned population_count(unsigned bits)
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		return __popcnt(bits);
+	#else
+		return static_cast<unsigned>(__builtin_popcount(bits));
+	#endif
+	}
+
+	inline bool cpu_supports_avx2()
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int registers[4];
+		__cpuid(registers, 1);
+		const bool os_saves_ymm = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+		__cpuidex(registers, 7, 0);
+		return os_saves_ymm && (registers[1] & (1 << 5));
+	#else
+		return __builtin_cpu_supports("avx2");
+	#endif
+	}
+
+	inline bool has_avx2()
+	{
+		static const bool supported = cpu_supports_avx2();
+		return supported;
+	}
+
+	/**
+	 * Permutation moving the lanes selected by an 8-bit mask to the front, for the AVX2 compress-store
+	 */
+	constexpr std::array<std::array<std::int32_t, 8>, 256> make_compress_permutations()
+	{
+		std::array<std::array<std::int32_t, 8>, 256> permutations{};
+		for (int mask = 0; mask < 256; ++mask)
+		{
+			int position = 0;
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					permutations[mask][position++] = lane;
+				}
+			}
+		}
+		return permutations;
+	}
+
+	alignas(32) inline constexpr auto COMPRESS_PERMUTATIONS = make_compress_permutations();
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define FOO_SIMD_TARGET_AVX2
+#else
+	#define FOO_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+	template <typename T>
+	struct Sse2;
+
+	template <>
+	struct Sse2<std::int32_t>
+	{
+		using Vector = __m128i;
+		static constexpr size_t Width = 4;
+
+		static Vector load(const std::int32_t* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+		static Vector broadcast(std::int32_t value) { return _mm_set1_epi32(value); }
+		static Vector equal(Vector a, Vector b) { return _mm_cmpeq_epi32(a, b); }
+		static Vector not_equal(Vector a, Vector b) { return _mm_xor_si128(_mm_cmpeq_epi32(a, b), _mm_set1_epi32(-1)); }
+		static Vector less(Vector a, Vector b) { return _mm_cmplt_epi32(a, b); }
+		static Vector greater(Vector a, Vector b) { return _mm_cmpgt_epi32(a, b); }
+		static Vector between(Vector a, Vector low, Vector high) { return _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi32(a, low), _mm_cmpgt_epi32(a, high)), _mm_set1_epi32(-1)); }
+		static unsigned bits(Vector mask) { return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask))); }
+
+		static size_t compress_store(std::int32_t* output, Vector values, unsigned mask)
+		{
+			alignas(16) std::int32_t lanes[Width];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), values);
+
+			size_t count = 0;
+			for (size_t lane = 0; lane < Width; ++lane)
+			{
+				output[count] = lanes[lane];
+				count += (mask >> lane) & 1u;
+			}
+			return count;
+		}
+	};
+
+	template <>
+	struct Sse2<float>
+	{
+		using Vector = __m128;
+		static constexpr size_t Width = 4;
+
+		static Vector load(const float* data) { return _mm_loadu_ps(data); }
+		static Vector broadcast(float value) { return _mm_set1_ps(value); }
+		static Vector equal(Vector a, Vector b) { return _mm_cmpeq_ps(a, b); }
+		static Vector not_equal(Vector a, Vector b) { return _mm_cmpneq_ps(a, b); }
+		static Vector less(Vector a, Vector b) { return _mm_cmplt_ps(a, b); }
+		static Vector greater(Vector a, Vector b) { return _mm_cmpgt_ps(a, b); }
+		static Vector between(Vector a, Vector low, Vector high) { return _mm_and_ps(_mm_cmpge_ps(a, low), _mm_cmple_ps(a, high)); }
+		static unsigned bits(Vector mask) { return static_cast<unsigned>(_mm_movemask_ps(mask)); }
+
+		static size_t compress_store(float* output, Vector values, unsigned mask)
+		{
+			alignas(16) float lanes[Width];
+			_mm_store_ps(lanes, values);
+
+			size_t count = 0;
+			for (size_t lane = 0; lane < Width; ++lane)
+			{
+				output[count] = lanes[lane];
+				count += (mask >> lane) & 1u;
+			}
+			return count;
+		}
+	};
+
+	template <typename T>
+	struct Avx2;
+
+	template <>
+	struct Avx2<std::int32_t>
+	{
+		using Vector = __m256i;
+		static constexpr size_t Width = 8;
+
+		FOO_SIMD_TARGET_AVX2 static Vector load(const std::int32_t* data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+		FOO_SIMD_TARGET_AVX2 static Vector broadcast(std::int32_t value) { return _mm256_set1_epi32(value); }
+		FOO_SIMD_TARGET_AVX2 static Vector equal(Vector a, Vector b) { return _mm256_cmpeq_epi32(a, b); }
+		FOO_SIMD_TARGET_AVX2 static Vector not_equal(Vector a, Vector b) { return _mm256_xor_si256(_mm256_cmpeq_epi32(a, b), _mm256_set1_epi32(-1)); }
+		FOO_SIMD_TARGET_AVX2 static Vector less(Vector a, Vector b) { return _mm256_cmpgt_epi32(b, a); }
+		FOO_SIMD_TARGET_AVX2 static Vector greater(Vector a, Vector b) { return _mm256_cmpgt_epi32(a, b); }
+		FOO_SIMD_TARGET_AVX2 static Vector between(Vector a, Vector low, Vector high) { return _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(low, a), _mm256_cmpgt_epi32(a, high)), _mm256_set1_epi32(-1)); }
+		FOO_SIMD_TARGET_AVX2 static unsigned bits(Vector mask) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))); }
+
+		FOO_SIMD_TARGET_AVX2 static size_t compress_store(std::int32_t* output, Vector values, unsigned mask)
+		{
+			const auto permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_PERMUTATIONS[mask].data()));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm256_permutevar8x32_epi32(values, permutation));
+			return population_count(mask);
+		}
+	};
+
+	template <>
+	struct Avx2<float>
+	{
+		using Vector = __m256;
+		static constexpr size_t Width = 8;
+
+		FOO_SIMD_TARGET_AVX2 static Vector load(const float* data) { return _mm256_loadu_ps(data); }
+		FOO_SIMD_TARGET_AVX2 static Vector broadcast(float value) { return _mm256_set1_ps(value); }
+		FOO_SIMD_TARGET_AVX2 static Vector equal(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		FOO_SIMD_TARGET_AVX2 static Vector not_equal(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+		FOO_SIMD_TARGET_AVX2 static Vector less(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		FOO_SIMD_TARGET_AVX2 static Vector greater(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		FOO_SIMD_TARGET_AVX2 static Vector between(Vector a, Vector low, Vector high) { return _mm256_and_ps(_mm256_cmp_ps(a, low, _CMP_GE_OQ), _mm256_cmp_ps(a, high, _CMP_LE_OQ)); }
+		FOO_SIMD_TARGET_AVX2 static unsigned bits(Vector mask) { return static_cast<unsigned>(_mm256_movemask_ps(mask)); }
+
+		FOO_SIMD_TARGET_AVX2 static size_t compress_store(float* output, Vector values, unsigned mask)
+		{
+			const auto permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(COMPRESS_PERMUTATIONS[mask].data()));
+			_mm256_storeu_ps(output, _mm256_permutevar8x32_ps(values, permutation));
+			return population_count(mask);
+		}
+	};
+}
+
+// the same kernels, compiled once per instruction set
+#define FOO_SIMD_NAMESPACE sse2
+#define FOO_SIMD_OPS Sse2
+#define FOO_SIMD_TARGET
+#include "SimdKernels.inl"
+#undef FOO_SIMD_NAMESPACE
+#undef FOO_SIMD_OPS
+#undef FOO_SIMD_TARGET
+
+#define FOO_SIMD_NAMESPACE avx2
+#define FOO_SIMD_OPS Avx2
+#define FOO_SIMD_TARGET FOO_SIMD_TARGET_AVX2
+#include "SimdKernels.inl"
+#undef FOO_SIMD_NAMESPACE
+#undef FOO_SIMD_OPS
+#undef FOO_SIMD_TARGET
+
+#undef FOO_SIMD_TARGET_AVX2
+
+#endif // FOO_HAS_SIMD
+
+namespace foo::simd
+{
+	/** Number of the elements filter() is called for at once, when filtering through a fixed-size buffer */
+	constexpr size_t FILTER_BLOCK_SIZE = 256;
+
+	/**
+	 * @returns index of the first element equal to \a value, or \a size if there is none
+	 */
+	template <typename T>
+	size_t find_equal(const T* data, size_t size, T value)
+	{
+		static_assert(IsVectorizableElement_v<T>, "no vectorized kernel for this element type");
+
+	#if FOO_HAS_SIMD
+		return detail::has_avx2()
+				? detail::avx2::find_equal(data, size, value)
+				: detail::sse2::find_equal(data, size, value);
+	#else
+		return size;
+	#endif
+	}
+
+	/**
+	 * Copies the elements of [data, data + size) satisfying \a predicate to \a output, preserving their order.
+	 *
+	 * @param output must have room for \a size elements (the kernels store whole vectors)
+	 *
+	 * @returns the number of elements written
+	 */
+	template <typename T, typename Predicate>
+	size_t filter(const T* data, size_t size, T* output, const Predicate& predicate)
+	{
+		static_assert(IsVectorizable_v<T, Predicate>, "no vectorized kernel for this element type or predicate");
+
+	#if FOO_HAS_SIMD
+		return detail::has_avx2()
+				? detail::avx2::filter(data, size, output, predicate)
+				: detail::sse2::filter(data, size, output, predicate);
+	#else
+		return 0;
+	#endif
+	}
+}
@@ -0,0 +1,87 @@
+// Included by Simd.h once per instruction set, with FOO_SIMD_NAMESPACE, FOO_SIMD_OPS and FOO_SIMD_TARGET defined
+
+namespace foo::simd::detail::FOO_SIMD_NAMESPACE
+{
+	template <typename T>
+	using OpsOf = FOO_SIMD_OPS<T>;
+
+	template <typename T>
+	FOO_SIMD_TARGET inline auto mask(typename OpsOf<T>::Vector values, const EqualTo<T>& predicate)
+	{
+		return OpsOf<T>::equal(values, OpsOf<T>::broadcast(predicate.value));
+	}
+
+	template <typename T>
+	FOO_SIMD_TARGET inline auto mask(typename OpsOf<T>::Vector values, const NotEqualTo<T>& predicate)
+	{
+		return OpsOf<T>::not_equal(values, OpsOf<T>::broadcast(predicate.value));
+	}
+
+	template <typename T>
+	FOO_SIMD_TARGET inline auto mask(typename OpsOf<T>::Vector values, const LessThan<T>& predicate)
+	{
+		return OpsOf<T>::less(values, OpsOf<T>::broadcast(predicate.value));
+	}
+
+	template <typename T>
+	FOO_SIMD_TARGET inline auto mask(typename OpsOf<T>::Vector values, const GreaterThan<T>& predicate)
+	{
+		return OpsOf<T>::greater(values, OpsOf<T>::broadcast(predicate.value));
+	}
+
+	template <typename T>
+	FOO_SIMD_TARGET inline auto mask(typename OpsOf<T>::Vector values, const InRange<T>& predicate)
+	{
+		return OpsOf<T>::between(values, OpsOf<T>::broadcast(predicate.low), OpsOf<T>::broadcast(predicate.high));
+	}
+
+	template <typename T>
+	FOO_SIMD_TARGET size_t find_equal(const T* data, size_t size, T value)
+	{
+		using Ops = OpsOf<T>;
+
+		const auto needle = Ops::broadcast(value);
+
+		size_t index = 0;
+		for (; index + Ops::Width <= size; index += Ops::Width)
+		{
+			const unsigned matches = Ops::bits(Ops::equal(Ops::load(data + index), needle));
+			if (matches != 0)
+			{
+				return index + count_trailing_zeros(matches);
+			}
+		}
+
+		for (; index < size; ++index)
+		{
+			if (data[index] == value)
+			{
+				return index;
+			}
+		}
+
+		return size;
+	}
+
+	template <typename T, typename Predicate>
+	FOO_SIMD_TARGET size_t filter(const T* data, size_t size, T* output, const Predicate& predicate)
+	{
+		using Ops = OpsOf<T>;
+
+		size_t count = 0;
+		size_t index = 0;
+		for (; index + Ops::Width <= size; index += Ops::Width)
+		{
+			const auto values = Ops::load(data + index);
+			count += Ops::compress_store(output + count, values, Ops::bits(mask<T>(values, predicate)));
+		}
+
+		for (; index < size; ++index)
+		{
+			output[count] = data[index];
+			count += predicate(data[index]) ? 1 : 0;
+		}
+
+		return count;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Find.h"
+#include "TypeTraits.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace foo
+{
+	/**
+	 * Binary search counterparts of foo::find() for containers sorted by the property obtainable via \a selector
+	 * (which can be a member pointer, a getter or foo::chained())
+	 *
+	 * @example:
+	 *  // items sorted by id
+	 *  auto item = foo::find_sorted(items, &Element::id, 42);
+	 *  auto [first, last] = foo::equal_range_by(items, foo::chained(&Element::date, &QDate::year), 2020);
+	 */
+	template <class Container, typename Selector, class ValueType>
+	auto lower_bound_by(Container&& container, Selector selector, const ValueType& value)
+	{
+		static_assert(!detail::CanMoveElementsOut_v<Container>, "lower_bound_by() on a temporary container would return a dangling iterator");
+
+		return std::lower_bound(std::begin(container), std::end(container), value, [&](const auto& element, const ValueType& searched)
+		{
+			return std::invoke(selector, element) < searched;
+		});
+	}
+
+	template <class Container, typename Selector, class ValueType>
+	auto upper_bound_by(Container&& container, Selector selector, const ValueType& value)
+	{
+		static_assert(!detail::CanMoveElementsOut_v<Container>, "upper_bound_by() on a temporary container would return a dangling iterator");
+
+		return std::upper_bound(std::begin(container), std::end(container), value, [&](const ValueType& searched, const auto& element)
+		{
+			return searched < std::invoke(selector, element);
+		});
+	}
+
+	/**
+	 * @returns pair of iterators delimiting the elements whose property equals \a value
+	 */
+	template <class Container, typename Selector, class ValueType>
+	auto equal_range_by(Container&& container, Selector selector, const ValueType& value)
+	{
+		static_assert(!detail::CanMoveElementsOut_v<Container>, "equal_range_by() on a temporary container would return dangling iterators");
+
+		auto first = lower_bound_by(container, selector, value);
+		auto last = std::upper_bound(first, std::end(container), value, [&](const ValueType& searched, const auto& element)
+		{
+			return searched < std::invoke(selector, element);
+		});
+
+		return std::make_pair(first, last);
+	}
+
+	/**
+	 * Finds the first element equal to \a value in a sorted \a container
+	 */
+	template <class Container, class ValueType>
+	auto find_sorted(Container&& container, const ValueType& value)
+		-> optional<traits::ValueTypeOf<Container>>
+	{
+		auto it = std::lower_bound(std::begin(container), std::end(container), value);
+		if (it != std::end(container) && *it == value)
+		{
+			return detail::make_found<Container>(*it);
+		}
+		else
+		{
+			return nullopt;
+		}
+	}
+
+	/**
+	 * Heterogenous find in a \a container sorted by the property obtainable via \a selector
+	 *
+	 * @returns optional<value_type of the Container> - the first element whose property equals \a value
+	 */
+	template <class Container, typename Selector, class ValueType>
+	auto find_sorted(Container&& container, Selector selector, const ValueType& value)
+		-> optional<traits::ValueTypeOf<Container>>
+	{
+		auto it = std::lower_bound(std::begin(container), std::end(container), value, [&](const auto& element, const ValueType& searched)
+		{
+			return std::invoke(selector, element) < searched;
+		});
+
+		if (it != std::end(container) && std::invoke(selector, *it) == value)
+		{
+			return detail::make_found<Container>(*it);
+		}
+		else
+		{
+			return nullopt;
+		}
+	}
+}
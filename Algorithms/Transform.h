@@ -1,14 +1,85 @@
 #pragma once
 
+#include "Execution.h"
+#include "TypeTraits.h"
+
 #include <algorithm>
 #include <memory>
 #include <functional>
+#include <vector>
 
 namespace foo
 {
+	/**
+	 * Whether the output of the fused algorithms (filter_transformed(), transformed_if()) should release the
+	 * capacity reserved for the elements that did not make it through
+	 */
+	enum class ShrinkToFit
+	{
+		No,
+		Yes
+	};
 
 	namespace detail
 	{
+		/**
+		 * Output, into which the results can be written directly through std::data() after a resize(),
+		 * instead of being push_back()-ed (with a capacity check and a size update per element)
+		 */
+		template <typename OutputContainer>
+		constexpr bool IsBulkWritable_v = traits::IsContiguousContainer_v<OutputContainer>
+										  && traits::HasResize_v<OutputContainer>
+										  && std::is_trivially_default_constructible_v<traits::ValueTypeOf<OutputContainer&>>
+										  && std::is_trivially_copy_assignable_v<traits::ValueTypeOf<OutputContainer&>>;
+
+		/**
+		 * Reserves \a output for \a count more elements - growing it geometrically, so that appending to the same output
+		 * over and over stays amortized linear (an exact reserve() would reallocate on every call)
+		 */
+		template <typename OutputContainer>
+		void reserve_for_append(OutputContainer& output, size_t count)
+		{
+			using SizeType = decltype(std::declval<OutputContainer>().size());
+
+			const auto needed = static_cast<size_t>(output.size()) + count;
+			if constexpr (traits::HasCapacity_v<OutputContainer>)
+			{
+				const auto capacity = static_cast<size_t>(output.capacity());
+				if (capacity < needed)
+				{
+					output.reserve(static_cast<SizeType>(std::max(2 * capacity, needed)));
+				}
+			}
+			else if (output.size() == 0)
+			{
+				output.reserve(static_cast<SizeType>(needed));
+			}
+		}
+
+		/**
+		 * Append the elements of Container transformed by Transform function to \a output
+		 */
+		template <typename Container, typename OutputContainer, typename Transform>
+		void append_transformed(const Container& input, OutputContainer& output, Transform&& transformer)
+		{
+			if constexpr (traits::HasSize_v<const Container> && IsBulkWritable_v<OutputContainer>)
+			{
+				using SizeType = decltype(std::declval<OutputContainer>().size());
+
+				const auto offset = static_cast<size_t>(output.size());
+				output.resize(static_cast<SizeType>(offset + static_cast<size_t>(std::size(input))));
+				std::transform(input.begin(), input.end(), std::data(output) + offset, std::forward<Transform>(transformer));
+			}
+			else
+			{
+				if constexpr (traits::HasSize_v<const Container> && traits::IsReservable_v<OutputContainer>)
+				{
+					reserve_for_append(output, static_cast<size_t>(std::size(input)));
+				}
+				std::transform(input.begin(), input.end(), std::back_inserter(output), std::forward<Transform>(transformer));
+			}
+		}
+
 		/**
 		 * Transform Container into OutputContainer based on Transform function
 		 */
@@ -18,11 +89,8 @@ namespace foo
 				  >
 		auto transformed_for_containers(const Container& input, Transform&& transformer)
 		{
-			using SizeType = decltype(std::declval<OutputContainer>().size());
-
 			OutputContainer output;
-			output.reserve(static_cast<SizeType>(input.size()));
-			std::transform(input.begin(), input.end(), std::back_inserter(output), std::forward<Transform>(transformer));
+			append_transformed(input, output, std::forward<Transform>(transformer));
 			return output;
 		}
 
@@ -38,6 +106,169 @@ namespace foo
 		{
 			return transformed_for_containers<Container<ContainerTypes...>, Transform, OutputContainer>(input, std::forward<Transform>(transformer));
 		}
+
+		/**
+		 * The "similar" Container that transformed() produces for Container and Transform function called with Argument
+		 */
+		template <typename Container, typename Transform, typename Argument = traits::ValueTypeOf<Container>>
+		struct TransformedContainer { using Type = Container; };
+
+		template <template <typename...> class Container, typename... ContainerTypes, typename Transform, typename Argument>
+		struct TransformedContainer<Container<ContainerTypes...>, Transform, Argument>
+		{
+			using Type = Container<std::decay_t<std::invoke_result_t<Transform, Argument>>>;
+		};
+
+		template <typename Container, typename Transform, typename Argument = traits::ValueTypeOf<Container>>
+		using TransformedContainer_t = typename TransformedContainer<Container, Transform, Argument>::Type;
+
+		template <typename Container>
+		constexpr bool IsReusableTemporary_v = !std::is_reference_v<Container> && !std::is_const_v<Container> && traits::IsOwningContainer_v<Container>;
+
+		/** How the elements of a temporary Container are passed to Transform - moved, unless it only takes lvalues (e.g. auto&) */
+		template <typename Container, typename Transform>
+		using TemporaryElement_t = std::conditional_t<std::is_invocable_v<Transform&, traits::ValueTypeOf<Container>&&>,
+													  traits::ValueTypeOf<Container>&&,
+													  traits::ValueTypeOf<Container>&>;
+
+		/**
+		 * Transform a temporary Container into OutputContainer based on Transform function
+		 *
+		 * If the element type does not change, the elements are transformed in place and the input storage is reused.
+		 * The elements are moved into the Transform function, or passed as lvalues if it does not take rvalues.
+		 */
+		template <typename OutputContainer, typename Container, typename Transform>
+		auto transformed_from_temporary(Container&& input, Transform&& transformer)
+		{
+			using ValueType = traits::ValueTypeOf<Container>;
+			using Element = TemporaryElement_t<Container, Transform>;
+			using ResultType = std::decay_t<std::invoke_result_t<Transform&, Element>>;
+
+			if constexpr (std::is_same_v<OutputContainer, Container> && std::is_same_v<ResultType, ValueType>)
+			{
+				for (auto& element : input)
+				{
+					element = std::invoke(transformer, static_cast<Element>(element));
+				}
+				return std::move(input);
+			}
+			else
+			{
+				OutputContainer output;
+				if constexpr (traits::HasReserve_v<OutputContainer>)
+				{
+					using SizeType = decltype(std::declval<OutputContainer>().size());
+					output.reserve(static_cast<SizeType>(input.size()));
+				}
+				for (auto& element : input)
+				{
+					output.push_back(std::invoke(transformer, static_cast<Element>(element)));
+				}
+				return output;
+			}
+		}
+
+		template <typename OutputContainer>
+		void shrink_to_fit(OutputContainer& output)
+		{
+			if constexpr (traits::HasShrinkToFit_v<OutputContainer>)
+			{
+				output.shrink_to_fit();
+			}
+			else if constexpr (traits::HasSqueeze_v<OutputContainer>)
+			{
+				output.squeeze();
+			}
+		}
+
+		/**
+		 * Single pass over the \a input, pushing transformed elements into OutputContainer.
+		 *
+		 * The output is reserved for all the input elements (the cheap upper bound), FilterTransformed decides
+		 * whether \a filter is applied to the input element (false) or to its transformed value (true).
+		 */
+		template <typename OutputContainer, bool FilterTransformed, typename Container, typename Filter, typename Transform>
+		OutputContainer filtered_and_transformed(const Container& input, Filter& filter, Transform& transformer, ShrinkToFit shrink)
+		{
+			OutputContainer output;
+			if constexpr (traits::HasReserve_v<OutputContainer> && traits::HasSize_v<const Container>)
+			{
+				using SizeType = decltype(std::declval<OutputContainer>().size());
+				output.reserve(static_cast<SizeType>(std::size(input)));
+			}
+
+			for (const auto& element : input)
+			{
+				if constexpr (FilterTransformed)
+				{
+					auto result = std::invoke(transformer, element);
+					if (std::invoke(filter, std::as_const(result)))
+					{
+						output.push_back(std::move(result));
+					}
+				}
+				else
+				{
+					if (std::invoke(filter, element))
+					{
+						output.push_back(std::invoke(transformer, element));
+					}
+				}
+			}
+
+			if (shrink == ShrinkToFit::Yes)
+			{
+				shrink_to_fit(output);
+			}
+			return output;
+		}
+
+		/**
+		 * Transform Container into OutputContainer based on Transform function, splitting the work into chunks according to the execution policy
+		 */
+		template <typename Container,
+				  typename Transform,
+				  typename OutputContainer,
+				  typename Policy
+				  >
+		auto transformed_for_containers(Policy policy, const Container& input, Transform&& transformer)
+		{
+			using SizeType = decltype(std::declval<OutputContainer>().size());
+			using ResultType = traits::ValueTypeOf<OutputContainer>;
+
+			const auto size = static_cast<size_t>(input.size());
+			auto chunks = detail::for_each_chunk(policy, input.begin(), size, [&transformer](auto first, auto last, size_t)
+			{
+				std::vector<ResultType> chunk_results;
+				chunk_results.reserve(static_cast<size_t>(std::distance(first, last)));
+				std::transform(first, last, std::back_inserter(chunk_results), transformer);
+				return chunk_results;
+			});
+
+			OutputContainer output;
+			if constexpr (IsBulkWritable_v<OutputContainer> && std::is_trivially_copyable_v<ResultType>)
+			{
+				// the chunks are just memcpy-ed into place
+				output.resize(static_cast<SizeType>(size));
+				auto destination = std::data(output);
+				for (const auto& chunk_results : chunks)
+				{
+					destination = std::copy(chunk_results.begin(), chunk_results.end(), destination);
+				}
+			}
+			else
+			{
+				if constexpr (traits::IsReservable_v<OutputContainer>)
+				{
+					output.reserve(static_cast<SizeType>(size));
+				}
+				for (auto& chunk_results : chunks)
+				{
+					std::move(chunk_results.begin(), chunk_results.end(), std::back_inserter(output));
+				}
+			}
+			return output;
+		}
 	}
 
 	/**
@@ -72,4 +303,190 @@ namespace foo
 		}
 	}
 
+	/**
+	 * Transform Container based on Transform function, appending the results to a caller-provided \a output
+	 *
+	 * Allows reusing the \a output between calls, or constructing it with an allocator (e.g. backed by a std::pmr arena)
+	 *
+	 * @returns \a output
+	 */
+	template <typename Container, typename OutputContainer, typename Transform>
+	OutputContainer& transformed_into(const Container& input, OutputContainer& output, Transform&& transformer)
+	{
+		detail::append_transformed(input, output, std::forward<Transform>(transformer));
+		return output;
+	}
+
+	/**
+	 * Transform Container into OutputContainer constructed with the \a allocator, based on Transform function
+	 *
+	 * @example:
+	 *  std::pmr::monotonic_buffer_resource arena;
+	 *  auto sizes = foo::transformedAs<std::pmr::vector<int>>(texts, [](auto str) { return str.size(); }, &arena);
+	 */
+	template <typename OutputContainer, typename Container, typename Transform, typename Allocator,
+			  typename = std::enable_if_t<!execution::IsExecutionPolicy_v<Container>>>
+	auto transformedAs(const Container& input, Transform&& transformer, const Allocator& allocator)
+	{
+		OutputContainer output(allocator);
+		detail::append_transformed(input, output, std::forward<Transform>(transformer));
+		return output;
+	}
+
+	/**
+	 * Fused transformed(filtered(input, filter), transformer) - filters and transforms in a single pass,
+	 * without the intermediate container
+	 *
+	 * @example:
+	 *  auto names = foo::filter_transformed(objects, &QObject::isWidgetType, &QObject::objectName);
+	 */
+	template <typename Container, typename Filter, typename Transform>
+	auto filter_transformed(const Container& input, Filter filter, Transform transformer, ShrinkToFit shrink = ShrinkToFit::No)
+	{
+		using OutputContainer = detail::TransformedContainer_t<Container, Transform&>;
+		return detail::filtered_and_transformed<OutputContainer, false>(input, filter, transformer, shrink);
+	}
+
+	/**
+	 * Fused filter_transformed() into explicitly specified OutputContainer, @see transformedAs()
+	 */
+	template <typename OutputContainer, typename Container, typename Filter, typename Transform>
+	auto filter_transformedAs(const Container& input, Filter filter, Transform transformer, ShrinkToFit shrink = ShrinkToFit::No)
+	{
+		return detail::filtered_and_transformed<OutputContainer, false>(input, filter, transformer, shrink);
+	}
+
+	/**
+	 * Transforms the \a input and keeps only the results satisfying \a filter (a "filter_map"), in a single pass
+	 *
+	 * @example:
+	 *  auto valid_ids = foo::transformed_if(texts, [](const QString& text){ return text.toInt(); }, [](int id){ return id > 0; });
+	 */
+	template <typename Container, typename Transform, typename Filter>
+	auto transformed_if(const Container& input, Transform transformer, Filter filter, ShrinkToFit shrink = ShrinkToFit::No)
+	{
+		using OutputContainer = detail::TransformedContainer_t<Container, Transform&>;
+		return detail::filtered_and_transformed<OutputContainer, true>(input, filter, transformer, shrink);
+	}
+
+	/**
+	 * Fused transformed_if() into explicitly specified OutputContainer, @see transformedAs()
+	 */
+	template <typename OutputContainer, typename Container, typename Transform, typename Filter>
+	auto transformed_ifAs(const Container& input, Transform transformer, Filter filter, ShrinkToFit shrink = ShrinkToFit::No)
+	{
+		return detail::filtered_and_transformed<OutputContainer, true>(input, filter, transformer, shrink);
+	}
+
+	/**
+	 * Transform a temporary Container into "similar" Container based on Transform function, reusing its storage where possible
+	 */
+	template <typename Container, typename Transform, std::enable_if_t<detail::IsReusableTemporary_v<Container>, int> = 0>
+	auto transformed(Container&& input, Transform&& transformer)
+	{
+		using OutputContainer = detail::TransformedContainer_t<Container, Transform&, detail::TemporaryElement_t<Container, Transform>>;
+		return detail::transformed_from_temporary<OutputContainer>(std::move(input), std::forward<Transform>(transformer));
+	}
+
+	/**
+	 * Transform a temporary Container into OutputContainer based on Transform function, reusing its storage where possible
+	 */
+	template <typename OutputContainer, typename Container, typename Transform, std::enable_if_t<detail::IsReusableTemporary_v<Container>, int> = 0>
+	auto transformedAs(Container&& input, Transform&& transformer)
+	{
+		return detail::transformed_from_temporary<OutputContainer>(std::move(input), std::forward<Transform>(transformer));
+	}
+
+	/** Default number of the transformed elements handed to the sink of transformed_streamed() at once */
+	constexpr size_t STREAMED_CHUNK_SIZE = 1024;
+
+	/**
+	 * Streaming transform - transforms the elements of [\a first, \a last) and hands the results to \a sink in chunks
+	 * of (at most) \a chunk_size elements, so that memory use stays constant regardless of the input length
+	 *
+	 * Works with input-only iterators, and \a last can be a sentinel of a different type (e.g. std::default_sentinel),
+	 * so the input does not need to be sized, or even to fit in memory.
+	 *
+	 * @example:
+	 *  std::ifstream file("values.txt");
+	 *  foo::transformed_streamed(std::istream_iterator<int>(file), std::istream_iterator<int>(), [](int value) { return value * 2; },
+	 *                            [&](std::vector<int>& chunk) { socket.write(chunk); });
+	 *
+	 * @note \a sink gets a non-const std::vector of the results, which it may move the elements (or the vector itself) out of.
+	 * The buffer is reused for the next chunk, unless the sink took it - then a new one is reserved.
+	 *
+	 * @returns number of the transformed elements
+	 */
+	template <typename Iterator, typename Sentinel, typename Transform, typename Sink,
+			  typename = std::enable_if_t<!traits::IsRange_v<Iterator>>>
+	size_t transformed_streamed(Iterator first, Sentinel last, Transform&& transformer, Sink&& sink, size_t chunk_size = STREAMED_CHUNK_SIZE)
+	{
+		using ResultType = std::decay_t<std::invoke_result_t<Transform&, decltype(*first)>>;
+
+		chunk_size = std::max<size_t>(chunk_size, 1);
+
+		std::vector<ResultType> chunk;
+		chunk.reserve(chunk_size);
+
+		size_t count = 0;
+		for (; first != last; ++first)
+		{
+			chunk.push_back(std::invoke(transformer, *first));
+			if (chunk.size() == chunk_size)
+			{
+				count += chunk.size();
+				std::invoke(sink, chunk);
+
+				chunk.clear();
+				if (chunk.capacity() < chunk_size)
+				{
+					chunk.reserve(chunk_size);
+				}
+			}
+		}
+
+		if (!chunk.empty())
+		{
+			count += chunk.size();
+			std::invoke(sink, chunk);
+		}
+		return count;
+	}
+
+	/**
+	 * Streaming transform of a whole \a input range (e.g. a C++20 std::generator), @see transformed_streamed(Iterator, Sentinel, ...)
+	 *
+	 * @example:
+	 *  foo::transformed_streamed(read_rows(socket), &parse_row, [&](std::vector<Row>& rows) { database.insert(rows); });
+	 */
+	template <typename Range, typename Transform, typename Sink,
+			  typename = std::enable_if_t<traits::IsRange_v<Range>>>
+	size_t transformed_streamed(Range&& input, Transform&& transformer, Sink&& sink, size_t chunk_size = STREAMED_CHUNK_SIZE)
+	{
+		return transformed_streamed(std::begin(input), std::end(input), std::forward<Transform>(transformer), std::forward<Sink>(sink), chunk_size);
+	}
+
+	/**
+	 * Transform Container into "similar" Container based on Transform function, splitting the work into chunks according to the execution \a policy
+	 *
+	 * @note The order of the elements is preserved. \a transformer must be safe to call concurrently.
+	 */
+	template <typename Policy, typename Container, typename Transform,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto transformed(Policy policy, const Container& input, Transform&& transformer)
+	{
+		using OutputContainer = detail::TransformedContainer_t<Container, Transform>;
+		return detail::transformed_for_containers<Container, Transform, OutputContainer>(policy, input, std::forward<Transform>(transformer));
+	}
+
+	/**
+	 * Transform Container into OutputContainer based on Transform function, splitting the work into chunks according to the execution \a policy
+	 */
+	template <typename OutputContainer, typename Policy, typename Container, typename Transform,
+			  typename = std::enable_if_t<execution::IsExecutionPolicy_v<Policy>>>
+	auto transformedAs(Policy policy, const Container& input, Transform&& transformer)
+	{
+		return detail::transformed_for_containers<Container, Transform, OutputContainer>(policy, input, std::forward<Transform>(transformer));
+	}
+
 }
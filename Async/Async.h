@@ -1,14 +1,22 @@
 #pragma once
 
+#include "Cancellation.h"
+#include "Executor.h"
 #include "Expected.h"
+#include "InplaceFunction.h"
+#include "Tracing.h"
 #include "TypeTraits.h"
 #include "FooGlobal.h"
 
 #include <QtConcurrent/QtConcurrentRun>
+#include <QException>
+#include <QFutureInterface>
 #include <QFutureWatcher>
 
 #include <boost/iterator/zip_iterator.hpp>
 
+#include <algorithm>
+#include <exception>
 #include <utility>
 #include <initializer_list>
 #include <functional>
@@ -25,21 +33,117 @@ namespace foo::async
 	public:
 		virtual void start() = 0;
 
+		/**
+		 * Sets the Executor the task runs its work on - nullptr (the default) means QtConcurrent on the global QThreadPool
+		 *
+		 * @note The executor must outlive the task
+		 */
+		virtual void setExecutor(Executor* executor)
+		{
+			mExecutor = executor;
+		}
+
+		Executor* executor() const
+		{
+			return mExecutor;
+		}
+
+		/**
+		 * Makes the task cancelled from the \a deadline on, @see cancel()
+		 *
+		 * @example:
+		 *  task->setDeadline(std::chrono::steady_clock::now() + std::chrono::seconds(5));
+		 */
+		void setDeadline(CancellationToken::Clock::time_point deadline)
+		{
+			mToken.setDeadline(deadline);
+		}
+
+		/** Names the task in the Tracer - \a name must outlive the tracer, i.e. is meant to be a string literal */
+		void setTraceName(const char* name)
+		{
+			mTrace.mName = name;
+		}
+
+		/** The token of the task - linked to the one of the weave()/queue() the task is a member of */
+		CancellationToken& cancellationToken()
+		{
+			return mToken;
+		}
+
+		/** The exception the work of the task ended by (nullptr if none) - readable from finished() until the task is deleted */
+		std::exception_ptr exception() const
+		{
+			return mException;
+		}
+
 	signals:
 		void finished(bool success) const;
 
 	public slots:
 		void finishWith(bool result)
 		{
+			if (std::exchange(mFinished, true))
+			{
+				return;
+			}
+
+			detail::trace_done(mTrace);
 			emit finished(result);
 			deleteLater();
 		}
+
+		/**
+		 * Cancels the task: work not started yet is skipped, running work stops where it polls cancellation_requested(),
+		 * and the task finishes unsuccessfully, without calling its callbacks
+		 *
+		 * For a weave()/queue(), all the members are cancelled (and the remaining members of a queue() or a weave_limited() are not started).
+		 */
+		void cancel()
+		{
+			mToken.cancel();
+		}
+
+	protected:
+		Executor*			mExecutor	= nullptr;
+		CancellationToken	mToken;
+		detail::TraceSpan	mTrace;
+		std::exception_ptr	mException;
+		bool				mFinished	= false;
 	};
 
 	namespace detail
 	{
 		using namespace foo;
 
+		/** Size of the captures of the onDone()/onError() callbacks, which are stored inline in the task */
+		constexpr size_t CALLBACK_CAPACITY = 64;
+
+		/**
+		 * The exception the finished \a future holds (nullptr if none) - without rethrowing it, as result() would
+		 *
+		 * Qt 6 keeps the original exception inside a QUnhandledException, which is unwrapped.
+		 */
+		template <typename ResultType>
+		std::exception_ptr exception_of(QFuture<ResultType> future)
+		{
+			try
+			{
+				future.waitForFinished();
+			}
+		#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+			catch (const QUnhandledException& exception)
+			{
+				return exception.exception() ? exception.exception() : std::current_exception();
+			}
+		#endif
+			catch (...)
+			{
+				return std::current_exception();
+			}
+			return nullptr;
+		}
+
 		/**
 		 * AsyncTask - class template for generic data object living in the heap, implementation supporting onDone() only
 		 */
@@ -50,23 +154,46 @@ namespace foo::async
 			AsyncTask(TaskType&& task)
 				: mWatcher()
 				, mTask(std::move(task))
-			{}
-
-			/** This is needed, so that MSVC does not complain about ambiguous onDone() (even though we have enable_if) */
-			template <int> struct dummy { dummy(int) {} };
-
-			/** Overload for VOID and ommited parameters */
-			template <typename CallbackType, typename = std::enable_if_t<!traits::IsCallable_v<CallbackType, ResultType>>>
-			void onDone(CallbackType&& callback, dummy<0> = 0)
 			{
-				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, std::forward<CallbackType>(callback));
+				// whether the task has no result to deliver - decided once, before the callbacks run
+				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, [this]
+				{
+					detail::trace_callback(mTrace);
+					// a skipped work has no result, even if the token is not cancelled anymore (e.g. by a later setDeadline())
+					mFailed = mSkipped || mToken.isCancelled();
+					// nor has a work which threw - result() would rethrow its exception out of the slot
+					if (!mFailed)
+					{
+						mException = exception_of(mWatcher.future());
+						mFailed = static_cast<bool>(mException);
+					}
+				});
 			}
 
-			/** Overload for callback with parameters */
-			template <typename CallbackType, typename = std::enable_if_t<traits::IsCallable_v<CallbackType, ResultType>>>
-			void onDone(CallbackType&& callback, dummy<1> = 0)
+			/** Accepts callbacks taking the result, as well as the ones ommiting it (and the ones for VOID results) */
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
 			{
-				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, [=]{ callback(mWatcher.result()); });
+				if constexpr (traits::IsCallable_v<CallbackType, ResultType>)
+				{
+					QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, [=]
+					{
+						if (!mFailed)
+						{
+							callback(mWatcher.result());
+						}
+					});
+				}
+				else
+				{
+					QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, [=]
+					{
+						if (!mFailed)
+						{
+							callback();
+						}
+					});
+				}
 			}
 
 			template <typename CallbackType>
@@ -77,13 +204,16 @@ namespace foo::async
 
 			void start() override
 			{
-				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, &AsyncTask::deleteLater);
-				mWatcher.setFuture(mTask());
+				detail::trace_submit(mTrace);
+				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, [this]{ finishWith(!mFailed); });
+				mWatcher.setFuture(mTask(mExecutor, mToken, &mTrace, &mSkipped));
 			}
 
 		private:
 			QFutureWatcher<ResultType>	mWatcher;
 			TaskType					mTask;
+			bool						mSkipped	= false;
+			bool						mFailed		= false;
 		};
 
 
@@ -91,7 +221,12 @@ namespace foo::async
 		 * AsyncTask - class template specialization for Expected<T, E>, supporting both onDone() and onError()
 		 */
 		template <typename ResultType, typename TaskType>
+	#if defined(FOO_HAS_CONCEPTS)
+			requires traits::SpecializationOf<ResultType, Expected>
+		class AsyncTask<ResultType, TaskType> : public AbstractTask
+	#else
 		class AsyncTask<ResultType, TaskType, std::enable_if_t<traits::IsSpecializationOf_v<Expected, ResultType>>> : public AbstractTask
+	#endif
 		{
 		public:
 			using SuccessType = typename ResultType::ValueType;
@@ -118,26 +253,44 @@ namespace foo::async
 
 			void start() override
 			{
+				detail::trace_submit(mTrace);
 				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, &AsyncTask::onFinished);
-				QObject::connect(&mWatcher, &QFutureWatcher<ResultType>::finished, this, &AsyncTask::deleteLater);
-				mWatcher.setFuture(mTask());
+				mWatcher.setFuture(mTask(mExecutor, mToken, &mTrace, &mSkipped));
 			}
 
 			void onFinished()
 			{
+				detail::trace_callback(mTrace);
+
+				// a skipped work has no result, even if the token is not cancelled anymore (e.g. by a later setDeadline())
+				if (mSkipped || mToken.isCancelled())
+				{
+					finishWith(false);
+					return;
+				}
+
+				// nor has a work which threw - result() would rethrow its exception out of the slot
+				mException = exception_of(mWatcher.future());
+				if (mException)
+				{
+					finishWith(false);
+					return;
+				}
+
 				auto result = mWatcher.result();
 				result.isValid()
 						? mSuccessCallback(result.value())
 						: mFailureCallback(result.error());
 
-				emit finished(result.isValid());
+				finishWith(result.isValid());
 			}
 
 		private:
 			QFutureWatcher<ResultType>			mWatcher;
 			TaskType							mTask;
-			std::function<void(SuccessType)>	mSuccessCallback;
-			std::function<void(FailureType)>	mFailureCallback;
+			bool								mSkipped	= false;
+			inplace_function<void(SuccessType), CALLBACK_CAPACITY>	mSuccessCallback;
+			inplace_function<void(FailureType), CALLBACK_CAPACITY>	mFailureCallback;
 		};
 
 
@@ -152,15 +305,30 @@ namespace foo::async
 
 			template <class... Tasks>
 			CompositeTask(Tasks... tasks)
-				: mTasks({ std::move(tasks)... })
+				: CompositeTask(QVector<AbstractTask*>{ std::move(tasks)... })
 			{
+			}
+
+			explicit CompositeTask(QVector<AbstractTask*> tasks)
+				: mTasks(std::move(tasks))
+			{
+				mTrace.mName = "weave";
+
 				for (auto task : mTasks)
 				{
+					task->cancellationToken().linkTo(mToken);
+
 					connect(task, &AbstractTask::finished, this, [this](bool success)
 					{
 						mAllSucceeded &= success;
 
-						if (++mFinishedCount >= mTasks.count())
+						if (!success && mFailFast)
+						{
+							// the result is known - stop the work of the other tasks
+							mToken.cancel();
+							finishWith(false);
+						}
+						else if (++mFinishedCount >= mTasks.count())
 						{
 							finishWith(mAllSucceeded);
 						}
@@ -168,18 +336,111 @@ namespace foo::async
 				}
 			}
 
+			/** Makes the task finish (and cancel the other tasks) as soon as any of the tasks fails */
+			void setFailFast(bool fail_fast)
+			{
+				mFailFast = fail_fast;
+			}
+
 			void start() override
 			{
+				detail::trace_submit(mTrace);
 				for (auto task : mTasks)
 				{
 					task->start();
 				}
 			}
 
+			/** The \a executor of a group applies to its tasks, which do not have an executor of their own */
+			void setExecutor(Executor* executor) override
+			{
+				AbstractTask::setExecutor(executor);
+				for (auto task : mTasks)
+				{
+					if (!task->executor())
+					{
+						task->setExecutor(executor);
+					}
+				}
+			}
+
 		protected:
 			QVector<AbstractTask*>	mTasks;
 			int						mFinishedCount	= 0;
 			bool					mAllSucceeded	= true;
+			bool					mFailFast		= false;
+		};
+
+
+		/**
+		 * @brief CompositeTask running at most the given number of its tasks at a time - the next task is started
+		 * whenever one finishes
+		 */
+		class ThrottledTask: public CompositeTask
+		{
+		public:
+			template <class... Tasks>
+			ThrottledTask(int max_in_flight, Tasks... tasks)
+				: ThrottledTask(max_in_flight, QVector<AbstractTask*>{ std::move(tasks)... })
+			{
+			}
+
+			ThrottledTask(int max_in_flight, QVector<AbstractTask*> tasks)
+				: CompositeTask(std::move(tasks))
+				, mMaxInFlight(std::max(max_in_flight, 1))
+			{
+				mTrace.mName = "weave_limited";
+
+				for (auto task : mTasks)
+				{
+					connect(task, &AbstractTask::finished, this, &ThrottledTask::startNext);
+				}
+			}
+
+			void start() override
+			{
+				detail::trace_submit(mTrace);
+				if (mTasks.isEmpty())
+				{
+					finishWith(true);
+					return;
+				}
+
+				while (mStartedCount < std::min(mMaxInFlight, mTasks.count()))
+				{
+					mTasks[mStartedCount++]->start();
+				}
+			}
+
+		private:
+			void startNext()
+			{
+				if (mStartedCount >= mTasks.count())
+				{
+					return;
+				}
+
+				if (mToken.isCancelled())
+				{
+					// the remaining tasks are never started - the group finishes once the running ones did
+					mAllSucceeded = false;
+					while (mStartedCount < mTasks.count())
+					{
+						mTasks[mStartedCount++]->deleteLater();
+						++mFinishedCount;
+					}
+					if (mFinishedCount >= mTasks.count())
+					{
+						finishWith(false);
+					}
+					return;
+				}
+
+				mTasks[mStartedCount++]->start();
+			}
+
+			int	mMaxInFlight;
+			int	mStartedCount	= 0;
 		};
 
 
@@ -190,6 +451,8 @@ namespace foo::async
 			FifoTask(Tasks... tasks)
 				: CompositeTask(tasks...)
 			{
+				mTrace.mName = "queue";
+
 				if (mTasks.isEmpty())
 				{
 					return;
@@ -199,27 +462,33 @@ namespace foo::async
 
 				// connect pairs of consecutive tasks so that when
 				// a preceding task finishes, the next one in the queue is started
-				for (auto task = mTasks.begin(), end = mTasks.end() - 1; task != end; ++task)
+				for (int index = 0; index + 1 < mTasks.count(); ++index)
 				{
-					auto next_task = *std::next(task);
-					connect(*task, &AbstractTask::finished, [this, next_task](bool success)
+					connect(mTasks[index], &AbstractTask::finished, this, [this, index](bool success)
 					{
-						if (!success)
+						if (!success || mToken.isCancelled())
 						{
+							// the remaining tasks are never started
+							for (int skipped = index + 1; skipped < mTasks.count(); ++skipped)
+							{
+								mTasks[skipped]->deleteLater();
+							}
 							finishWith(false);
 							return;
 						}
 
-						next_task->start();
+						mTasks[index + 1]->start();
 					});
 				}
 			}
 
 			void start() override
 			{
+				detail::trace_submit(mTrace);
 				if (mTasks.isEmpty())
 				{
 					finishWith(true);
+					return;
 				}
 
 				mTasks.first()->start();
@@ -258,6 +527,13 @@ namespace foo::async
 				return *this;
 			}
 
+			/** Names the task in the Tracer, @see AbstractTask::setTraceName() */
+			TaskBuilder& named(const char* name)
+			{
+				mTask->setTraceName(name);
+				return *this;
+			}
+
 			AbstractTask* get()
 			{
 				return mTask;
@@ -272,6 +548,49 @@ namespace foo::async
 		{
 			return TaskBuilder<ResultType, TaskType>{ std::forward<TaskType>(task) };
 		}
+
+		/**
+		 * QtConcurrent::run() counterpart for an Executor - posts std::invoke(function, args...) to the \a executor
+		 *
+		 * @returns QFuture of the result
+		 */
+		template <typename ResultType, typename Function, typename... Args>
+		QFuture<ResultType> run_on(Executor& executor, Function function, Args... args)
+		{
+			QFutureInterface<ResultType> promise;
+			promise.reportStarted();
+			auto future = promise.future();
+
+			executor.post([promise, function = std::move(function), args...]() mutable
+			{
+				try
+				{
+					if constexpr (std::is_void_v<ResultType>)
+					{
+						std::invoke(function, args...);
+					}
+					else
+					{
+						promise.reportResult(std::invoke(function, args...));
+					}
+				}
+				catch (const QException& exception)
+				{
+					promise.reportException(exception);
+				}
+				catch (...)
+				{
+				#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+					promise.reportException(QUnhandledException(std::current_exception()));
+				#else
+					promise.reportException(QUnhandledException());
+				#endif
+				}
+				promise.reportFinished();
+			});
+
+			return future;
+		}
 	}
 
 
@@ -300,25 +619,152 @@ namespace foo::async
 			.start();
 
 	 *
+	 * @note A work ending by an exception finishes the task unsuccessfully, without the callbacks - @see AbstractTask::exception()
 	 */
-	template <typename... Params>
+	template <typename... Params, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Params...>>>
 	auto task(Params&&... params)
 	{
 		using ResultType = foo::traits::FirstTemplateParameter_t<decltype(QtConcurrent::run(std::forward<Params>(params)...))>;
-		return detail::make_async_task<ResultType>( [=]{ return QtConcurrent::run(params...); } );
+		return detail::make_async_task<ResultType>( [=](Executor* executor, const CancellationToken& token, detail::TraceSpan* trace, bool* skipped)
+		{
+			// QtConcurrent-specific forms of the parameters (e.g. object, member function) can only run via QtConcurrent
+			if constexpr (std::is_invocable_v<const std::decay_t<Params>&...>)
+			{
+				// the work of a cancelled task is skipped (recorded in \a skipped, read once the future finished),
+				// and running work can poll cancellation_requested()
+				auto work = [token, trace, skipped, params...]() -> ResultType
+				{
+					detail::TraceRunScope trace_scope(trace);
+					CancellationScope scope(token);
+					if (token.isCancelled())
+					{
+						*skipped = true;
+						throw TaskCancelled();
+					}
+					return std::invoke(params...);
+				};
+
+				if (executor)
+				{
+					return detail::run_on<ResultType>(*executor, std::move(work));
+				}
+				return QtConcurrent::run(std::move(work));
+			}
+			else
+			{
+				return QtConcurrent::run(params...);
+			}
+		});
+	}
+
+	/**
+	 * @brief Creates an AsyncTask, which runs std::invoke(function, args...) on the given \a executor
+	 *
+	 * @example:
+	 *  foo::async::WorkStealingPool pool;
+	 *  foo::async::task(pool, [=]{ return checksum(data); })
+	 *      .onDone([](quint32 sum) { qDebug() << sum; })
+	 *      .get()->start();
+	 */
+	template <typename Function, typename... Args>
+	auto task(Executor& executor, Function&& function, Args&&... args)
+	{
+		static_assert(std::is_invocable_v<const std::decay_t<Function>&, const std::decay_t<Args>&...>, "task(executor, ...) runs std::invoke(function, args...)");
+
+		auto builder = task(std::forward<Function>(function), std::forward<Args>(args)...);
+		builder.get()->setExecutor(&executor);
+		return builder;
 	}
 
 
 
-	template <typename... Tasks>
+	template <typename... Tasks, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Tasks...>>>
 	auto weave(Tasks&&... tasks) -> AbstractTask*
 	{
 		return new detail::CompositeTask(std::forward<Tasks>(tasks)...);
 	}
 
-	template <typename... Tasks>
+	template <typename... Tasks, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Tasks...>>>
 	auto queue(Tasks&&... tasks) -> AbstractTask*
 	{
 		return new detail::FifoTask(std::forward<Tasks>(tasks)...);
 	}
+
+	/**
+	 * weave() running at most \a max_in_flight of the \a tasks at a time, the next one starting as soon as one finishes
+	 *
+	 * @example: (5000 downloads, with 8 connections at a time)
+	 *
+		QVector<foo::async::AbstractTask*> downloads;
+		for (const auto& url : urls)
+		{
+			downloads.append(foo::async::task(download, url).onDone(store).get());
+		}
+		foo::async::weave_limited(8, downloads)->start();
+
+	 */
+	template <typename... Tasks, typename = std::enable_if_t<std::conjunction_v<std::is_convertible<Tasks, AbstractTask*>...>>>
+	auto weave_limited(int max_in_flight, Tasks&&... tasks) -> AbstractTask*
+	{
+		return new detail::ThrottledTask(max_in_flight, std::forward<Tasks>(tasks)...);
+	}
+
+	/**
+	 * weave_limited() of a range of AbstractTask*
+	 */
+	template <typename Range, typename = std::enable_if_t<traits::IsRange_v<Range>>>
+	auto weave_limited(int max_in_flight, const Range& tasks) -> AbstractTask*
+	{
+		QVector<AbstractTask*> members;
+		for (auto task : tasks)
+		{
+			members.append(task);
+		}
+		return new detail::ThrottledTask(max_in_flight, std::move(members));
+	}
+
+	/**
+	 * weave() finishing as soon as any of the \a tasks fails - the other tasks are cancelled then, so that their
+	 * not yet started work is skipped and the running one can stop early (@see cancellation_requested())
+	 */
+	template <typename... Tasks, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Tasks...>>>
+	auto weave_fail_fast(Tasks&&... tasks) -> AbstractTask*
+	{
+		auto composite = new detail::CompositeTask(std::forward<Tasks>(tasks)...);
+		composite->setFailFast(true);
+		return composite;
+	}
+
+	/**
+	 * weave() running the \a tasks (which do not have an executor of their own) on the \a executor
+	 */
+	template <typename... Tasks>
+	auto weave(Executor& executor, Tasks&&... tasks) -> AbstractTask*
+	{
+		auto composite = weave(std::forward<Tasks>(tasks)...);
+		composite->setExecutor(&executor);
+		return composite;
+	}
+
+	/**
+	 * weave_fail_fast() running the \a tasks (which do not have an executor of their own) on the \a executor
+	 */
+	template <typename... Tasks>
+	auto weave_fail_fast(Executor& executor, Tasks&&... tasks) -> AbstractTask*
+	{
+		auto composite = weave_fail_fast(std::forward<Tasks>(tasks)...);
+		composite->setExecutor(&executor);
+		return composite;
+	}
+
+	/**
+	 * queue() running the \a tasks (which do not have an executor of their own) on the \a executor
+	 */
+	template <typename... Tasks>
+	auto queue(Executor& executor, Tasks&&... tasks) -> AbstractTask*
+	{
+		auto composite = queue(std::forward<Tasks>(tasks)...);
+		composite->setExecutor(&executor);
+		return composite;
+	}
 }
@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+
+#include <Foo/Core/Async.h>
+#include <Foo/Core/LightTask.h>
+#include <Foo/Core/WorkStealingPool.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+
+/**
+ * Overhead of the tasks - each iteration starts a batch of trivial tasks and runs the event loop until all their
+ * callbacks ran. The "per_task" counter is the time per task (the work itself is a single addition).
+ */
+namespace
+{
+	constexpr int TASK_COUNT = 1'000'000;
+
+	template <typename Start>
+	void run_tasks(benchmark::State& state, Start start)
+	{
+		const auto count = static_cast<int>(state.range(0));
+
+		for (auto _ : state)
+		{
+			int done = 0;
+			for (int index = 0; index < count; ++index)
+			{
+				start(index, done);
+			}
+			while (done < count)
+			{
+				QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+			}
+			// processEvents() does not delete the finished (deleteLater()-ed) tasks - free them before the next batch
+			QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+		}
+
+		state.counters["per_task"] = benchmark::Counter(static_cast<double>(count), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+	}
+
+	void BM_task(benchmark::State& state)
+	{
+		run_tasks(state, [](int index, int& done)
+		{
+			foo::async::task([index] { return index + 1; })
+				.onDone([&done](int) { ++done; })
+				.get()->start();
+		});
+	}
+
+	void BM_task_on_pool(benchmark::State& state)
+	{
+		foo::async::WorkStealingPool pool;
+		run_tasks(state, [&pool](int index, int& done)
+		{
+			foo::async::task(pool, [index] { return index + 1; })
+				.onDone([&done](int) { ++done; })
+				.get()->start();
+		});
+	}
+
+	void BM_light_task(benchmark::State& state)
+	{
+		run_tasks(state, [](int index, int& done)
+		{
+			foo::async::light_task([index] { return index + 1; })
+				.onDone([&done](int) { ++done; })
+				.start();
+		});
+	}
+
+	void BM_light_task_on_pool(benchmark::State& state)
+	{
+		foo::async::WorkStealingPool pool;
+		run_tasks(state, [&pool](int index, int& done)
+		{
+			foo::async::light_task(pool, [index] { return index + 1; })
+				.onDone([&done](int) { ++done; })
+				.start();
+		});
+	}
+}
+
+BENCHMARK(BM_task)->Arg(TASK_COUNT)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_task_on_pool)->Arg(TASK_COUNT)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_light_task)->Arg(TASK_COUNT)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_light_task_on_pool)->Arg(TASK_COUNT)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv)
+{
+	// the callbacks are delivered through the event loop
+	QCoreApplication application(argc, argv);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	return 0;
+}
@@ -0,0 +1,820 @@
+#include <Foo/External/catch.hpp>
+
+#include <Foo/Core/Async.h>
+#include <Foo/Core/Coroutine.h>
+#include <Foo/Core/LightTask.h>
+#include <Foo/Core/TaskGraph.h>
+#include <Foo/Core/TaskPipeline.h>
+#include <Foo/Core/Tracing.h>
+#include <Foo/Core/WorkStealingPool.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QException>
+#include <QPointer>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+	/** The event loop the tasks deliver their results by */
+	void ensure_application()
+	{
+		if (!QCoreApplication::instance())
+		{
+			static int argc = 1;
+			static char name[] = "Async_test";
+			static char* argv[] = { name, nullptr };
+			static QCoreApplication application(argc, argv);
+		}
+	}
+
+	/** Runs the event loop until the \a condition holds - e.g. until the callbacks of light tasks ran */
+	template <typename Condition>
+	void wait_until(Condition condition)
+	{
+		while (!condition())
+		{
+			QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+		}
+	}
+
+	/** Executor running the posted jobs only when asked to, so that a test decides when the work runs */
+	class ManualExecutor : public foo::async::Executor
+	{
+	public:
+		void post(Job job) override
+		{
+			mJobs.push_back(std::move(job));
+		}
+
+		void runAll()
+		{
+			while (!mJobs.empty())
+			{
+				auto job = std::move(mJobs.front());
+				mJobs.pop_front();
+				job();
+			}
+		}
+
+	private:
+		std::deque<Job> mJobs;
+	};
+
+	/** Task only recording that it was started */
+	class StartRecorder : public foo::async::AbstractTask
+	{
+	public:
+		explicit StartRecorder(bool& started)
+			: mStarted(started)
+		{
+		}
+
+		void start() override
+		{
+			mStarted = true;
+			finishWith(true);
+		}
+
+	private:
+		bool& mStarted;
+	};
+
+	/** Task recording its \a id in the order of the starts, and finishing (with \a success) within start() */
+	class OrderRecorder : public foo::async::AbstractTask
+	{
+	public:
+		OrderRecorder(QVector<int>& order, int id, bool success = true)
+			: mOrder(order)
+			, mId(id)
+			, mSuccess(success)
+		{
+		}
+
+		void start() override
+		{
+			mOrder.append(mId);
+			finishWith(mSuccess);
+		}
+
+	private:
+		QVector<int>&	mOrder;
+		int				mId;
+		bool			mSuccess;
+	};
+
+	/** Task which does nothing when started - the test finishes it, by finishWith() */
+	class ManualTask : public foo::async::AbstractTask
+	{
+	public:
+		void start() override
+		{
+		}
+	};
+
+	/**
+	 * Work running until cancellation_requested() (or until it gives up, after a while), which records that it
+	 * started running and whether it was asked to stop
+	 */
+	auto work_until_cancelled(std::atomic<bool>& running, std::atomic<bool>& stopped)
+	{
+		return [&running, &stopped]
+		{
+			running = true;
+			const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (!foo::async::cancellation_requested() && std::chrono::steady_clock::now() < give_up)
+			{
+				std::this_thread::yield();
+			}
+			stopped = foo::async::cancellation_requested();
+			return 0;
+		};
+	}
+
+	/** Waits (without the event loop) until the work of a task started running */
+	void wait_running(const std::atomic<bool>& running)
+	{
+		while (!running)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	/** Exception thrown by the work of a task - a QException, so that QFuture keeps it as is */
+	class WorkFailure : public QException
+	{
+	public:
+		void raise() const override
+		{
+			throw *this;
+		}
+
+		WorkFailure* clone() const override
+		{
+			return new WorkFailure(*this);
+		}
+	};
+
+	/** Records the finished() of a task - to be created before the task is started */
+	class Finished
+	{
+	public:
+		explicit Finished(foo::async::AbstractTask* task)
+		{
+			ensure_application();
+			QObject::connect(task, &foo::async::AbstractTask::finished, [this](bool success) { mSuccess = success; });
+		}
+
+		Finished(const Finished&) = delete;
+		Finished& operator=(const Finished&) = delete;
+
+		/** Whether the task finished already - without running the event loop */
+		bool done() const
+		{
+			return mSuccess.has_value();
+		}
+
+		/** Runs the event loop until the task finished (and the deleteLater()-ed tasks are deleted), @returns its success */
+		bool wait()
+		{
+			while (!mSuccess)
+			{
+				QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+			}
+			QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+			return *mSuccess;
+		}
+
+	private:
+		std::optional<bool> mSuccess;
+	};
+
+#if defined(FOO_HAS_COROUTINES)
+	foo::async::CoTask<int> doubled(int value)
+	{
+		co_return 2 * co_await foo::async::task([value] { return value; });
+	}
+
+	foo::async::CoTask<int> unpacked(int value)
+	{
+		co_return co_await foo::async::task([value] { return common::make_expected(value); });
+	}
+
+	foo::async::CoTask<int> cancelling_itself(foo::async::AbstractTask*& self)
+	{
+		const auto value = co_await foo::async::task([] { return 42; });
+		self->cancel();
+		co_return value;
+	}
+
+	foo::async::CoTask<int> awaiting_until_cancelled(std::atomic<bool>& running, std::atomic<bool>& stopped)
+	{
+		co_return co_await foo::async::task(work_until_cancelled(running, stopped));
+	}
+
+	foo::async::CoTask<bool> caught_work_failure()
+	{
+		try
+		{
+			co_await foo::async::task([]() -> int { throw WorkFailure(); });
+		}
+		catch (const WorkFailure&)
+		{
+			co_return true;
+		}
+		co_return false;
+	}
+#endif
+}
+
+TEST_CASE("WorkStealingPool")
+{
+	SECTION("a job posted by a busy worker is stolen by another one")
+	{
+		std::thread::id poster;
+		std::thread::id runner;
+		std::promise<void> ran;
+		auto ran_future = ran.get_future();
+		{
+			foo::async::WorkStealingPool pool(2);
+
+			// the posting worker waits for the nested job, so only the other worker can run it
+			pool.post([&]
+			{
+				poster = std::this_thread::get_id();
+				pool.post([&]
+				{
+					runner = std::this_thread::get_id();
+					ran.set_value();
+				});
+				ran_future.wait();
+			});
+		}
+
+		CHECK(runner != std::thread::id());
+		CHECK(runner != poster);
+	}
+
+	SECTION("the destructor runs the remaining jobs, also the ones they post")
+	{
+		using namespace std::chrono_literals;
+
+		std::atomic<int> count{ 0 };
+		{
+			foo::async::WorkStealingPool pool(2);
+			for (int index = 0; index < 1000; ++index)
+			{
+				pool.post([&pool, &count]
+				{
+					std::this_thread::sleep_for(1us);
+					pool.post([&count] { ++count; });
+					++count;
+				});
+			}
+		}
+
+		CHECK(count == 2000);
+	}
+}
+
+TEST_CASE("task")
+{
+	SECTION("emits finished once the callbacks ran")
+	{
+		int value = 0;
+		auto task = foo::async::task([] { return 42; }).onDone([&value](int result) { value = result; }).get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK(finished.wait());
+		CHECK(value == 42);
+	}
+
+	SECTION("skipped work does not reach the callbacks, even if the token is not cancelled anymore")
+	{
+		using Clock = foo::async::CancellationToken::Clock;
+
+		ManualExecutor executor;
+		bool called = false;
+
+		auto task = foo::async::task(executor, [] { return 42; }).onDone([&called] { called = true; }).get();
+		auto light = foo::async::light_task(executor, [] { return 42; }).onDone([&called] { called = true; }).get();
+
+		Finished task_finished(task);
+		Finished light_finished(light);
+		for (auto cancelled : { task, light })
+		{
+			cancelled->setDeadline(Clock::now());
+			cancelled->start();
+		}
+
+		executor.runAll();
+		for (auto cancelled : { task, light })
+		{
+			cancelled->setDeadline(Clock::time_point::max());
+		}
+
+		CHECK_FALSE(task_finished.wait());
+		CHECK_FALSE(light_finished.wait());
+		CHECK_FALSE(called);
+	}
+}
+
+TEST_CASE("task which throws")
+{
+	SECTION("finishes unsuccessfully, without the callbacks, and keeps the exception")
+	{
+		bool called = false;
+		std::exception_ptr exception;
+		auto task = foo::async::task([]() -> int { throw WorkFailure(); }).onDone([&called] { called = true; }).get();
+		QObject::connect(task, &foo::async::AbstractTask::finished, [&exception, task] { exception = task->exception(); });
+
+		Finished finished(task);
+		task->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(called);
+		CHECK_THROWS_AS(std::rethrow_exception(exception), WorkFailure);
+	}
+}
+
+#if defined(FOO_HAS_COROUTINES)
+TEST_CASE("CoTask")
+{
+	SECTION("co_await of a task() resumes the coroutine with its result")
+	{
+		int value = 0;
+		auto task = doubled(21).onDone([&value](int result) { value = result; }).get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK(finished.wait());
+		CHECK(value == 42);
+	}
+
+	SECTION("co_await unpacks the value of an Expected")
+	{
+		int value = 0;
+		auto task = unpacked(42).onDone([&value](int result) { value = result; }).get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK(finished.wait());
+		CHECK(value == 42);
+	}
+
+	SECTION("co_await rethrows the exception the work of the task threw")
+	{
+		bool caught = false;
+		auto task = caught_work_failure().onDone([&caught](bool result) { caught = result; }).get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK(finished.wait());
+		CHECK(caught);
+	}
+
+	SECTION("cancelled while awaiting, the coroutine finishes unsuccessfully, without onDone()")
+	{
+		std::atomic<bool> running{ false };
+		std::atomic<bool> stopped{ false };
+		bool called = false;
+		auto task = awaiting_until_cancelled(running, stopped).onDone([&called](int) { called = true; }).get();
+
+		Finished finished(task);
+		task->start();
+		wait_running(running);
+		task->cancel();
+
+		CHECK_FALSE(finished.wait());
+		CHECK(stopped);
+		CHECK_FALSE(called);
+	}
+
+	SECTION("cancelled after its last co_await, the coroutine finishes unsuccessfully, without onDone()")
+	{
+		bool called = false;
+		foo::async::AbstractTask* self = nullptr;
+		auto task = cancelling_itself(self).onDone([&called](int) { called = true; }).get();
+		self = task;
+
+		Finished finished(task);
+		task->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(called);
+	}
+}
+#endif
+
+TEST_CASE("cancellation of groups")
+{
+	SECTION("a failing member of weave_fail_fast() finishes the group at once, and asks the others to stop")
+	{
+		std::atomic<bool> running{ false };
+		std::atomic<bool> stopped{ false };
+		auto sibling = foo::async::task(work_until_cancelled(running, stopped)).get();
+		auto failing = new ManualTask;
+
+		auto weave = foo::async::weave_fail_fast(sibling, failing);
+		Finished weave_finished(weave);
+		Finished sibling_finished(sibling);
+		weave->start();
+
+		wait_running(running);
+		failing->finishWith(false);
+
+		CHECK(weave_finished.done());
+		CHECK_FALSE(weave_finished.wait());
+		CHECK_FALSE(sibling_finished.wait());
+		CHECK(stopped);
+	}
+
+	SECTION("the deadline of a weave() cancels the members not started yet")
+	{
+		using Clock = foo::async::CancellationToken::Clock;
+
+		std::atomic<bool> ran{ false };
+		bool called = false;
+		auto first = foo::async::task([&ran] { ran = true; return 1; }).onDone([&called] { called = true; }).get();
+		auto second = foo::async::task([&ran] { ran = true; return 2; }).onDone([&called] { called = true; }).get();
+
+		auto weave = foo::async::weave(first, second);
+		weave->setDeadline(Clock::now());
+		Finished finished(weave);
+		weave->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(ran);
+		CHECK_FALSE(called);
+	}
+
+	SECTION("the running step of a queue() sees the cancel() of the queue")
+	{
+		std::atomic<bool> running{ false };
+		std::atomic<bool> stopped{ false };
+		bool next_called = false;
+		auto first = foo::async::task(work_until_cancelled(running, stopped)).get();
+		auto second = foo::async::task([] { return 2; }).onDone([&next_called] { next_called = true; }).get();
+
+		auto queue = foo::async::queue(first, second);
+		Finished finished(queue);
+		queue->start();
+
+		wait_running(running);
+		queue->cancel();
+
+		CHECK_FALSE(finished.wait());
+		CHECK(stopped);
+		CHECK_FALSE(next_called);
+	}
+}
+
+TEST_CASE("light_task")
+{
+	ensure_application();
+
+	SECTION("onDone() receives the result")
+	{
+		std::optional<int> value;
+		foo::async::light_task([] { return 42; }).onDone([&value](int result) { value = result; }).start();
+
+		wait_until([&value] { return value.has_value(); });
+		CHECK(*value == 42);
+	}
+
+	SECTION("an Expected result is unpacked to onDone() and onError()")
+	{
+		std::optional<int> value;
+		std::optional<std::error_code> error;
+
+		foo::async::light_task([] { return common::make_expected(42); })
+			.onDone([&value](int result) { value = result; })
+			.start();
+		foo::async::light_task([]() -> Expected<int, std::error_code> { return common::make_unexpected(std::make_error_code(std::errc::io_error)); })
+			.onDone([&value](int result) { value = -result; })
+			.onError([&error](std::error_code failure) { error = failure; })
+			.start();
+
+		wait_until([&value, &error] { return value && error; });
+		CHECK(*value == 42);
+		CHECK(*error == std::errc::io_error);
+	}
+
+	SECTION("a burst of finished tasks is completed in the start order")
+	{
+		ManualExecutor executor;
+		QVector<int> order;
+		QVector<int> expected;
+		for (int index = 0; index < 100; ++index)
+		{
+			foo::async::light_task(executor, [index] { return index; }).onDone([&order](int result) { order.append(result); }).start();
+			expected.append(index);
+		}
+
+		executor.runAll();
+
+		wait_until([&order] { return order.size() == 100; });
+		CHECK(order == expected);
+	}
+
+	SECTION("get() composes light tasks with weave() and queue()")
+	{
+		int sum = 0;
+		auto add = [&sum](int value) { return foo::async::light_task([value] { return value; }).onDone([&sum](int result) { sum += result; }).get(); };
+
+		auto weave = foo::async::weave(add(1), add(2));
+		Finished weave_finished(weave);
+		weave->start();
+		CHECK(weave_finished.wait());
+
+		auto queue = foo::async::queue(add(3), add(4));
+		Finished queue_finished(queue);
+		queue->start();
+		CHECK(queue_finished.wait());
+
+		CHECK(sum == 10);
+	}
+}
+
+TEST_CASE("queue")
+{
+	SECTION("runs the steps one after another")
+	{
+		QVector<int> order;
+		auto first = foo::async::task([] { return 1; }).onDone([&order](int step) { order.append(step); }).get();
+		auto second = foo::async::task([] { return 2; }).onDone([&order](int step) { order.append(step); }).get();
+
+		auto queue = foo::async::queue(first, second);
+		Finished finished(queue);
+		queue->start();
+
+		CHECK(finished.wait());
+		CHECK(order == QVector<int>{ 1, 2 });
+	}
+
+	SECTION("deletes the steps it skips once a step failed")
+	{
+		bool ran = false;
+		auto first = foo::async::task([] { return 1; }).get();
+		QPointer<foo::async::AbstractTask> second = foo::async::task([&ran] { ran = true; return 2; }).get();
+		first->cancel();
+
+		auto queue = foo::async::queue(first, second.data());
+		Finished finished(queue);
+		queue->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(ran);
+		CHECK(second.isNull());
+	}
+}
+
+TEST_CASE("weave_limited")
+{
+	SECTION("runs every task")
+	{
+		int sum = 0;
+		QVector<foo::async::AbstractTask*> tasks;
+		for (int index = 1; index <= 5; ++index)
+		{
+			tasks.append(foo::async::task([index] { return index; }).onDone([&sum](int value) { sum += value; }).get());
+		}
+
+		auto weave = foo::async::weave_limited(2, tasks);
+		Finished finished(weave);
+		weave->start();
+
+		CHECK(finished.wait());
+		CHECK(sum == 15);
+	}
+
+	SECTION("does not start the remaining tasks once cancelled, and deletes them")
+	{
+		bool started = false;
+		foo::async::AbstractTask* weave = nullptr;
+		auto first = foo::async::task([] { return 1; }).onDone([&weave] { weave->cancel(); }).get();
+		QPointer<foo::async::AbstractTask> second = new StartRecorder(started);
+		QPointer<foo::async::AbstractTask> third = new StartRecorder(started);
+
+		weave = foo::async::weave_limited(1, first, second.data(), third.data());
+		Finished finished(weave);
+		weave->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(started);
+		CHECK(second.isNull());
+		CHECK(third.isNull());
+	}
+}
+
+TEST_CASE("TaskGraph")
+{
+	SECTION("starts a task once all its predecessors succeeded")
+	{
+		QVector<int> order;
+		auto record = [&order](int id) { return foo::async::task([id] { return id; }).onDone([&order](int step) { order.append(step); }).get(); };
+
+		auto graph = new foo::async::TaskGraph;
+		const auto fetch = graph->add(record(0));
+		const auto compile = graph->add(record(1), { fetch });
+		const auto docs = graph->add(record(2), { fetch });
+		graph->add(record(3), { compile, docs });
+
+		Finished finished(graph);
+		graph->start();
+
+		CHECK(finished.wait());
+		REQUIRE(order.size() == 4);
+		CHECK(order.first() == 0);
+		CHECK(order.last() == 3);
+	}
+
+	SECTION("starts the ready task on the longest path first")
+	{
+		QVector<int> order;
+
+		auto graph = new foo::async::TaskGraph;
+		graph->setMaxInFlight(1);
+		graph->add(new OrderRecorder(order, 0));
+		const auto head = graph->add(new OrderRecorder(order, 1));
+		graph->add(new OrderRecorder(order, 2), { head }, 10);
+
+		Finished finished(graph);
+		graph->start();
+
+		CHECK(finished.wait());
+		CHECK(order == QVector<int>{ 1, 2, 0 });
+	}
+
+	SECTION("a failed task stops the graph, and the tasks not started are deleted")
+	{
+		QVector<int> order;
+
+		auto graph = new foo::async::TaskGraph;
+		const auto failing = graph->add(new OrderRecorder(order, 0, false), {}, 10);
+		QPointer<foo::async::AbstractTask> independent = new OrderRecorder(order, 1);
+		QPointer<foo::async::AbstractTask> dependent = new OrderRecorder(order, 2);
+		graph->add(independent.data());
+		graph->add(dependent.data(), { failing });
+
+		Finished finished(graph);
+		graph->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK(order == QVector<int>{ 0 });
+		CHECK(independent.isNull());
+		CHECK(dependent.isNull());
+	}
+}
+
+TEST_CASE("pipeline")
+{
+	SECTION("move-only results pass through the stages to onDone()")
+	{
+		std::unique_ptr<int> result;
+		auto task = foo::async::pipeline(
+					[] { return std::make_unique<int>(20); },
+					[](std::unique_ptr<int> value) { *value += 22; return value; })
+				.onDone([&result](std::unique_ptr<int> value) { result = std::move(value); })
+				.get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK(finished.wait());
+		REQUIRE(result);
+		CHECK(*result == 42);
+	}
+
+	SECTION("the error of an Expected stage ends the pipeline and goes to onError()")
+	{
+		bool ran = false;
+		std::error_code error;
+		auto task = foo::async::pipeline(
+					[]() -> Expected<int, std::error_code> { return common::make_unexpected(std::make_error_code(std::errc::io_error)); },
+					[&ran](int value) { ran = true; return value; })
+				.onError([&error](std::error_code failure) { error = failure; })
+				.get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(ran);
+		CHECK(error == std::errc::io_error);
+	}
+
+	SECTION("cancelled after its last stage ran, the pipeline finishes unsuccessfully, without the callbacks")
+	{
+		bool called = false;
+		foo::async::AbstractTask* task = nullptr;
+		task = foo::async::pipeline(
+					[] { return 20; },
+					[&task](int value) { task->cancel(); return value + 22; })
+				.onDone([&called](int) { called = true; })
+				.get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(called);
+	}
+
+	SECTION("a throwing stage finishes the pipeline unsuccessfully, without the callbacks")
+	{
+		bool called = false;
+		auto task = foo::async::pipeline(
+					[]() -> int { throw WorkFailure(); },
+					[](int value) { return value; })
+				.onDone([&called](int) { called = true; })
+				.get();
+
+		Finished finished(task);
+		task->start();
+
+		CHECK_FALSE(finished.wait());
+		CHECK_FALSE(called);
+	}
+}
+
+TEST_CASE("LatencyHistogram")
+{
+	using namespace std::chrono_literals;
+
+	SECTION("counts the durations in power of two buckets of microseconds")
+	{
+		foo::async::LatencyHistogram histogram;
+		histogram.add(0us);
+		histogram.add(1us);
+		histogram.add(3us);
+		histogram.add(1000us);
+		histogram.add(std::chrono::hours(1));
+
+		const auto& buckets = histogram.buckets();
+		CHECK(buckets[0] == 2);
+		CHECK(buckets[1] == 1);
+		CHECK(buckets[9] == 1);
+		CHECK(buckets[foo::async::LatencyHistogram::BUCKET_COUNT - 1] == 1);
+		CHECK(histogram.count() == 5);
+		CHECK(histogram.total() == std::chrono::hours(1) + 1004us);
+	}
+
+	SECTION("percentile() is the upper bound of the bucket holding the quantile")
+	{
+		foo::async::LatencyHistogram histogram;
+		CHECK(histogram.percentile(0.5) == foo::async::LatencyHistogram::Duration::zero());
+
+		for (int index = 0; index < 90; ++index)
+		{
+			histogram.add(3us);
+		}
+		for (int index = 0; index < 10; ++index)
+		{
+			histogram.add(1000us);
+		}
+
+		CHECK(histogram.percentile(0.0) == 4us);
+		CHECK(histogram.percentile(0.5) == 4us);
+		CHECK(histogram.percentile(0.9) == 4us);
+		CHECK(histogram.percentile(0.99) == 1024us);
+		CHECK(histogram.percentile(1.0) == 1024us);
+	}
+}
+
+TEST_CASE("Tracer")
+{
+	SECTION("stamps the work and the callbacks of a light task composed as an AbstractTask")
+	{
+		auto& tracer = foo::async::Tracer::instance();
+		tracer.clear();
+		foo::async::Tracer::setEnabled(true);
+
+		auto task = foo::async::light_task([] { return 42; }).get();
+		task->setTraceName("traced_light_task");
+
+		Finished finished(task);
+		task->start();
+		CHECK(finished.wait());
+		foo::async::Tracer::setEnabled(false);
+
+		const auto latencies = tracer.latencies().at("traced_light_task");
+		CHECK(latencies.mQueueWait.count() == 1);
+		CHECK(latencies.mRun.count() == 1);
+		CHECK(latencies.mDelivery.count() == 1);
+		CHECK(latencies.mTotal.count() == 1);
+	}
+}
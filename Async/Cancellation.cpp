@@ -0,0 +1,88 @@
+#include "Cancellation.h"
+
+#include <limits>
+#include <utility>
+
+namespace foo::async
+{
+	struct CancellationToken::State
+	{
+		bool isCancelled() const
+		{
+			for (auto state = this; state; state = state->mParent.get())
+			{
+				if (state->mCancelled.load(std::memory_order_acquire))
+				{
+					return true;
+				}
+
+				const auto deadline = state->mDeadline.load(std::memory_order_relaxed);
+				if (deadline != NO_DEADLINE && Clock::now().time_since_epoch().count() >= deadline)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static constexpr Clock::rep NO_DEADLINE = std::numeric_limits<Clock::rep>::max();
+
+		std::atomic<bool>			mCancelled	= false;
+		std::atomic<Clock::rep>		mDeadline	= NO_DEADLINE;
+		std::shared_ptr<State>		mParent;
+	};
+}
+
+namespace
+{
+	/** The token of the work running on this thread, set by a CancellationScope */
+	thread_local const foo::async::CancellationToken* tCurrentToken = nullptr;
+}
+
+namespace foo::async
+{
+	CancellationToken::CancellationToken()
+		: mState(std::make_shared<State>())
+	{
+	}
+
+	void CancellationToken::cancel()
+	{
+		mState->mCancelled.store(true, std::memory_order_release);
+	}
+
+	bool CancellationToken::isCancelled() const
+	{
+		return mState->isCancelled();
+	}
+
+	void CancellationToken::setDeadline(Clock::time_point deadline)
+	{
+		mState->mDeadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+	}
+
+	void CancellationToken::linkTo(const CancellationToken& parent)
+	{
+		mState->mParent = parent.mState;
+	}
+
+	CancellationToken CancellationToken::current()
+	{
+		return tCurrentToken ? *tCurrentToken : CancellationToken();
+	}
+
+	bool cancellation_requested()
+	{
+		return tCurrentToken && tCurrentToken->isCancelled();
+	}
+
+	CancellationScope::CancellationScope(const CancellationToken& token)
+		: mPrevious(std::exchange(tCurrentToken, &token))
+	{
+	}
+
+	CancellationScope::~CancellationScope()
+	{
+		tCurrentToken = mPrevious;
+	}
+}
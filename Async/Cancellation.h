@@ -0,0 +1,104 @@
+#pragma once
+
+#include "FooGlobal.h"
+
+#include <QException>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace foo::async
+{
+	/**
+	 * @brief Shared flag telling the work of a task to stop - cancelled explicitly, or once its deadline passed
+	 *
+	 * Tokens form a tree following the composition of the tasks: a token linked to a parent is cancelled whenever
+	 * the parent is, so cancelling a weave()/queue() reaches all its members, and their running work.
+	 *
+	 * @example: (polling from the work)
+	 *
+		foo::async::task([=]
+		{
+			for (const auto& file : files)
+			{
+				if (foo::async::cancellation_requested())
+				{
+					return false;
+				}
+				index(file);
+			}
+			return true;
+		});
+
+	 * @note Copies of a token share its state
+	 */
+	class FOOSHARED_EXPORT CancellationToken
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		CancellationToken();
+
+		void cancel();
+
+		bool isCancelled() const;
+
+		/** Makes the token cancelled from the \a deadline on */
+		void setDeadline(Clock::time_point deadline);
+
+		/**
+		 * Makes this token cancelled whenever the \a parent is
+		 *
+		 * @note Meant for composing the tasks, i.e. must not be called while the token is being checked from other threads
+		 */
+		void linkTo(const CancellationToken& parent);
+
+		/** The token of the task whose work runs on the calling thread (a token never cancelled outside of a task) */
+		static CancellationToken current();
+
+	private:
+		struct State;
+
+		std::shared_ptr<State> mState;
+	};
+
+	/**
+	 * Whether the task whose work runs on the calling thread was cancelled - for long running work to poll
+	 */
+	FOOSHARED_EXPORT bool cancellation_requested();
+
+	/**
+	 * @brief Makes the \a token the current one of the calling thread, for the scope of the work of a task
+	 */
+	class FOOSHARED_EXPORT CancellationScope
+	{
+	public:
+		/** @note The \a token must outlive the scope */
+		explicit CancellationScope(const CancellationToken& token);
+		~CancellationScope();
+
+		CancellationScope(const CancellationScope&) = delete;
+		CancellationScope& operator=(const CancellationScope&) = delete;
+
+	private:
+		const CancellationToken* mPrevious;
+	};
+
+	/**
+	 * @brief Thrown instead of running the work of a task cancelled before its work started
+	 */
+	class FOOSHARED_EXPORT TaskCancelled : public QException
+	{
+	public:
+		void raise() const override
+		{
+			throw *this;
+		}
+
+		TaskCancelled* clone() const override
+		{
+			return new TaskCancelled(*this);
+		}
+	};
+}
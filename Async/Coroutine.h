@@ -0,0 +1,532 @@
+#pragma once
+
+#include "Async.h"
+#include "LightTask.h"
+
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#define FOO_HAS_COROUTINES
+#endif
+
+#if defined(FOO_HAS_COROUTINES)
+
+#include <QDebug>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace foo::async
+{
+	/**
+	 * @brief Thrown by co_await of a task whose Expected result holds an error - the exception counterpart of onError()
+	 */
+	template <typename ErrorType>
+	class TaskError : public QException
+	{
+	public:
+		explicit TaskError(ErrorType error)
+			: mError(std::move(error))
+		{
+		}
+
+		const ErrorType& error() const
+		{
+			return mError;
+		}
+
+		void raise() const override
+		{
+			throw *this;
+		}
+
+		TaskError* clone() const override
+		{
+			return new TaskError(*this);
+		}
+
+	private:
+		ErrorType mError;
+	};
+
+	template <typename ResultType>
+	class CoTask;
+
+	namespace detail
+	{
+		/**
+		 * How co_await unpacks a ResultType - to the value of an Expected (the error is thrown as TaskError),
+		 * or to the result itself
+		 */
+		template <typename ResultType, typename Enabled = void>
+		struct Awaited
+		{
+			using Value = ResultType;
+
+			struct Error {};
+		};
+
+		template <typename ResultType>
+		struct Awaited<ResultType, std::enable_if_t<traits::IsSpecializationOf_v<Expected, ResultType>>>
+		{
+			using Value = typename ResultType::ValueType;
+			using Error = typename ResultType::ErrorType;
+		};
+
+		/** Storage of an awaited value - a flag for VOID */
+		template <typename Value>
+		using AwaitedStorage = std::optional<std::conditional_t<std::is_void_v<Value>, bool, Value>>;
+
+		/** Links the token of the awaited \a task to the one of the awaiting coroutine, if that is a CoTask */
+		template <typename Promise>
+		void link_to_awaiting(AbstractTask* task, std::coroutine_handle<Promise> awaiting)
+		{
+			if constexpr (requires { awaiting.promise().mTask->cancellationToken(); })
+			{
+				task->cancellationToken().linkTo(awaiting.promise().mTask->cancellationToken());
+			}
+		}
+
+		/** Starts the \a task, resuming the \a awaiting coroutine once it finished - on the thread the task was created on */
+		template <typename Promise>
+		void start_awaited(AbstractTask* task, std::coroutine_handle<Promise> awaiting)
+		{
+			link_to_awaiting(task, awaiting);
+
+			// finished() is emitted also when the task was cancelled, i.e. without calling the callbacks
+			QObject::connect(task, &AbstractTask::finished, task, [awaiting] { awaiting.resume(); });
+			task->start();
+		}
+
+		/**
+		 * Awaiter of the task of a TaskBuilder (or a LightTaskBuilder) - the result is taken by the onDone()/onError() callbacks,
+		 * and the exception the work threw from the task before it is deleted
+		 */
+		template <typename ResultType, typename Builder>
+		class TaskAwaiter
+		{
+		public:
+			using Value = typename Awaited<ResultType>::Value;
+			using Error = typename Awaited<ResultType>::Error;
+
+			explicit TaskAwaiter(Builder&& builder)
+				: mBuilder(std::move(builder))
+			{
+			}
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			template <typename Promise>
+			void await_suspend(std::coroutine_handle<Promise> awaiting)
+			{
+				if constexpr (std::is_void_v<Value>)
+				{
+					mBuilder.onDone([this] { mValue.emplace(true); });
+				}
+				else
+				{
+					mBuilder.onDone([this](Value value) { mValue.emplace(std::move(value)); });
+				}
+
+				if constexpr (traits::IsSpecializationOf_v<Expected, ResultType>)
+				{
+					mBuilder.onError([this](Error error) { mError.emplace(std::move(error)); });
+				}
+
+				auto task = mBuilder.get();
+				QObject::connect(task, &AbstractTask::finished, task, [this, task] { mException = task->exception(); });
+				start_awaited(task, awaiting);
+			}
+
+			Value await_resume()
+			{
+				if (mException)
+				{
+					std::rethrow_exception(mException);
+				}
+				if (mError)
+				{
+					throw TaskError<Error>(std::move(*mError));
+				}
+				if (!mValue)
+				{
+					throw TaskCancelled();
+				}
+
+				if constexpr (!std::is_void_v<Value>)
+				{
+					return std::move(*mValue);
+				}
+			}
+
+		private:
+			Builder					mBuilder;
+			AwaitedStorage<Value>	mValue;
+			std::optional<Error>	mError;
+			std::exception_ptr		mException;
+		};
+
+		template <typename ResultType>
+		class CoroutineTask;
+
+		/** The promise of a CoTask coroutine - the result (or the exception) is kept until the task is deleted */
+		template <typename ResultType>
+		struct CoPromiseBase
+		{
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept
+				{
+					return false;
+				}
+
+				template <typename Promise>
+				void await_suspend(std::coroutine_handle<Promise> coroutine) noexcept
+				{
+					coroutine.promise().mTask->complete();
+				}
+
+				void await_resume() const noexcept
+				{
+				}
+			};
+
+			CoTask<ResultType> get_return_object();
+
+			std::suspend_always initial_suspend() const noexcept
+			{
+				return {};
+			}
+
+			FinalAwaiter final_suspend() const noexcept
+			{
+				return {};
+			}
+
+			void unhandled_exception()
+			{
+				mException = std::current_exception();
+			}
+
+			CoroutineTask<ResultType>*	mTask	= nullptr;
+			std::exception_ptr			mException;
+		};
+
+		template <typename ResultType>
+		struct CoPromise : CoPromiseBase<ResultType>
+		{
+			template <typename Result>
+			void return_value(Result&& result)
+			{
+				mResult.emplace(std::forward<Result>(result));
+			}
+
+			std::optional<ResultType> mResult;
+		};
+
+		template <>
+		struct CoPromise<void> : CoPromiseBase<void>
+		{
+			void return_void()
+			{
+				mResult = true;
+			}
+
+			bool mResult = false;
+		};
+
+		/**
+		 * AbstractTask running a coroutine - start() runs it up to its first co_await, and it finishes when the coroutine returns
+		 *
+		 * The success is the one of the returned Expected (true for other results); a coroutine ending by an exception is
+		 * unsuccessful - an escaping TaskError<ErrorType> (of the Expected returned by the coroutine) is passed to onError().
+		 */
+		template <typename ResultType>
+		class CoroutineTask : public AbstractTask
+		{
+		public:
+			using Handle = std::coroutine_handle<CoPromise<ResultType>>;
+
+			explicit CoroutineTask(Handle coroutine)
+				: mCoroutine(coroutine)
+			{
+				mTrace.mName = "coroutine";
+			}
+
+			~CoroutineTask() override
+			{
+				mCoroutine.destroy();
+			}
+
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
+			{
+				mCallbacks.onDone(std::forward<CallbackType>(callback));
+			}
+
+			template <typename CallbackType>
+			void onError(CallbackType&& callback)
+			{
+				mCallbacks.onError(std::forward<CallbackType>(callback));
+			}
+
+			void start() override
+			{
+				if (mToken.isCancelled())
+				{
+					finishWith(false);
+					return;
+				}
+
+				detail::trace_submit(mTrace);
+				mCoroutine.resume();
+			}
+
+			/** Called once the coroutine returned */
+			void complete()
+			{
+				auto& promise = mCoroutine.promise();
+
+				bool success = false;
+				if (mToken.isCancelled())
+				{
+					// cancelled after the last co_await - finishes unsuccessfully, without the callbacks, like any cancelled task
+				}
+				else if (promise.mException)
+				{
+					fail(promise.mException);
+				}
+				else if constexpr (std::is_void_v<ResultType>)
+				{
+					success = mCallbacks.deliver();
+				}
+				else
+				{
+					success = mCallbacks.deliver(*promise.mResult);
+				}
+
+				finishWith(success);
+			}
+
+			/** The coroutine is co_await-ed - the exception it ends by is rethrown by takeResult() then, not reported */
+			void setAwaited()
+			{
+				mAwaited = true;
+			}
+
+			/** The result of the coroutine, for a coroutine awaiting it - rethrows the exception it ended by */
+			typename Awaited<ResultType>::Value takeResult()
+			{
+				auto& promise = mCoroutine.promise();
+				if (mToken.isCancelled())
+				{
+					throw TaskCancelled();
+				}
+				if (promise.mException)
+				{
+					std::rethrow_exception(promise.mException);
+				}
+				if (!promise.mResult)
+				{
+					throw TaskCancelled();
+				}
+
+				if constexpr (traits::IsSpecializationOf_v<Expected, ResultType>)
+				{
+					auto& result = *promise.mResult;
+					if (!result.isValid())
+					{
+						throw TaskError<typename ResultType::ErrorType>(result.error());
+					}
+					return std::move(result.value());
+				}
+				else if constexpr (!std::is_void_v<ResultType>)
+				{
+					return std::move(*promise.mResult);
+				}
+			}
+
+		private:
+			/** Passes the TaskError of the returned Expected to onError(), and reports the other exceptions nobody takes */
+			void fail(const std::exception_ptr& exception)
+			{
+				try
+				{
+					std::rethrow_exception(exception);
+				}
+				catch (const TaskError<typename Awaited<ResultType>::Error>& error)
+				{
+					if constexpr (traits::IsSpecializationOf_v<Expected, ResultType>)
+					{
+						if (mCallbacks.mFailure)
+						{
+							mCallbacks.mFailure(error.error());
+						}
+					}
+				}
+				catch (const TaskCancelled&)
+				{
+					// an awaited task was cancelled - the task finishes unsuccessfully, like any cancelled one
+				}
+				catch (const std::exception& error)
+				{
+					if (!mAwaited)
+					{
+						qWarning() << "foo::async::CoTask: the coroutine ended by an exception:" << error.what();
+					}
+				}
+				catch (...)
+				{
+					if (!mAwaited)
+					{
+						qWarning() << "foo::async::CoTask: the coroutine ended by an unknown exception";
+					}
+				}
+			}
+
+			Handle						mCoroutine;
+			LightCallbacks<ResultType>	mCallbacks;
+			bool						mAwaited	= false;
+		};
+
+		/** Awaiter of a CoTask - the result is taken from the finished coroutine (resumed from finished(), before its task is deleted) */
+		template <typename ResultType>
+		class CoTaskAwaiter
+		{
+		public:
+			explicit CoTaskAwaiter(CoroutineTask<ResultType>* task)
+				: mTask(task)
+			{
+			}
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			template <typename Promise>
+			void await_suspend(std::coroutine_handle<Promise> awaiting)
+			{
+				mTask->setAwaited();
+				start_awaited(mTask, awaiting);
+			}
+
+			typename Awaited<ResultType>::Value await_resume()
+			{
+				return mTask->takeResult();
+			}
+
+		private:
+			CoroutineTask<ResultType>* mTask;
+		};
+	}
+
+	/**
+	 * @brief Coroutine task - the return type of a coroutine co_await-ing other tasks, which is itself a task
+	 *
+	 * The coroutine starts suspended: it runs once the task is started (directly, or by weave()/queue()), or co_await-ed
+	 * by another coroutine. Awaiting a task() resumes the coroutine on the thread it runs on, with the result of the task
+	 * (Expected is unpacked - its error is thrown as TaskError), so the nested onDone() callbacks become sequential code.
+	 * An exception the work of the task threw is rethrown by the co_await.
+	 *
+	 * @example:
+	 *
+		foo::async::CoTask<Expected<qint64, std::error_code>> total_size(QStringList files)
+		{
+			qint64 total = 0;
+			for (const auto& file : files)
+			{
+				total += co_await foo::async::task(file_size, file);
+			}
+			co_return common::make_expected(total);
+		}
+
+		total_size(files)
+			.onDone([](qint64 size) { qDebug() << "total:" << size; })
+			.onError([](std::error_code error) { qDebug() << "error:" << error.value(); })
+			.get()->start();
+
+	 * @note Cancelling the task cancels the awaited tasks (the co_await then throws TaskCancelled), and like any cancelled
+	 * task it finishes unsuccessfully, without the callbacks - also when cancelled after its last co_await
+	 *
+	 * @note A coroutine ending by an exception finishes unsuccessfully, without onDone(). A TaskError of the returned
+	 * Expected is passed to onError(), an awaiting coroutine gets the exception rethrown by its co_await, and any other
+	 * exception is reported by qWarning() (TaskCancelled is not).
+	 */
+	template <typename ResultType>
+	class CoTask
+	{
+	public:
+		using promise_type = detail::CoPromise<ResultType>;
+
+		explicit CoTask(detail::CoroutineTask<ResultType>* task)
+			: mTask(task)
+		{
+		}
+
+		template <typename CallbackType>
+		CoTask& onDone(CallbackType&& callback)
+		{
+			mTask->onDone(std::forward<CallbackType>(callback));
+			return *this;
+		}
+
+		template <typename CallbackType>
+		CoTask& onError(CallbackType&& callback)
+		{
+			mTask->onError(std::forward<CallbackType>(callback));
+			return *this;
+		}
+
+		/** Names the task in the Tracer, @see AbstractTask::setTraceName() */
+		CoTask& named(const char* name)
+		{
+			mTask->setTraceName(name);
+			return *this;
+		}
+
+		AbstractTask* get()
+		{
+			return mTask;
+		}
+
+		detail::CoTaskAwaiter<ResultType> operator co_await() &&
+		{
+			return detail::CoTaskAwaiter<ResultType>{ mTask };
+		}
+
+	private:
+		detail::CoroutineTask<ResultType>* mTask;
+	};
+
+	namespace detail
+	{
+		template <typename ResultType>
+		CoTask<ResultType> CoPromiseBase<ResultType>::get_return_object()
+		{
+			auto& promise = static_cast<CoPromise<ResultType>&>(*this);
+			mTask = new CoroutineTask<ResultType>(std::coroutine_handle<CoPromise<ResultType>>::from_promise(promise));
+			return CoTask<ResultType>{ mTask };
+		}
+
+		/** co_await foo::async::task(...) */
+		template <typename ResultType, typename TaskType>
+		TaskAwaiter<ResultType, TaskBuilder<ResultType, TaskType>> operator co_await(TaskBuilder<ResultType, TaskType>&& builder)
+		{
+			return TaskAwaiter<ResultType, TaskBuilder<ResultType, TaskType>>{ std::move(builder) };
+		}
+
+		/** co_await foo::async::light_task(...) */
+		template <typename ResultType, typename Function>
+		TaskAwaiter<ResultType, LightTaskBuilder<ResultType, Function>> operator co_await(LightTaskBuilder<ResultType, Function>&& builder)
+		{
+			return TaskAwaiter<ResultType, LightTaskBuilder<ResultType, Function>>{ std::move(builder) };
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "FooGlobal.h"
+
+#include <QThreadPool>
+
+#include <functional>
+#include <type_traits>
+
+namespace foo::async
+{
+	/**
+	 * @brief Runs the work of the tasks - an interface, so that each group of tasks can use the executor suited
+	 * for its work (e.g. a WorkStealingPool for many short CPU-bound jobs, a dedicated QThreadPool for blocking I/O)
+	 *
+	 * @example:
+	 *  foo::async::WorkStealingPool cpu_pool;
+	 *  foo::async::ThreadPoolExecutor io_pool(&blocking_thread_pool);
+	 *
+	 *  foo::async::weave(cpu_pool, foo::async::task(hash, chunk1).get(), foo::async::task(hash, chunk2).get())->start();
+	 *  foo::async::task(io_pool, read_file, path).onDone(show).get()->start();
+	 */
+	class FOOSHARED_EXPORT Executor
+	{
+	public:
+		using Job = std::function<void()>;
+
+		virtual ~Executor() = default;
+
+		/** Schedules the \a job to be run (on any thread of the executor) */
+		virtual void post(Job job) = 0;
+	};
+
+	/**
+	 * @brief Executor submitting the jobs to a QThreadPool (the global instance by default)
+	 */
+	class FOOSHARED_EXPORT ThreadPoolExecutor : public Executor
+	{
+	public:
+		explicit ThreadPoolExecutor(QThreadPool* pool = QThreadPool::globalInstance())
+			: mPool(pool)
+		{
+		}
+
+		void post(Job job) override
+		{
+			mPool->start(std::move(job));
+		}
+
+	private:
+		QThreadPool* mPool;
+	};
+
+	namespace detail
+	{
+		/** Whether Params... start with an Executor, i.e. select the task()/weave()/queue() overloads taking one */
+		template <typename... Params>
+		struct StartsWithExecutor : std::false_type {};
+
+		template <typename First, typename... Params>
+		struct StartsWithExecutor<First, Params...> : std::is_base_of<Executor, std::decay_t<First>> {};
+
+		template <typename... Params>
+		constexpr bool StartsWithExecutor_v = StartsWithExecutor<Params...>::value;
+	}
+}
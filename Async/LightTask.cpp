@@ -0,0 +1,92 @@
+#include "LightTask.h"
+
+#include <QCoreApplication>
+
+#include <thread>
+
+namespace
+{
+	const auto FINISHED_EVENT = static_cast<QEvent::Type>(QEvent::registerEventType());
+}
+
+namespace foo::async::detail
+{
+	LightDispatcher::~LightDispatcher()
+	{
+		// the workers of the running tasks still post() to this dispatcher - wait until the last one is done with it
+		while (mRunning.load(std::memory_order_acquire) != 0)
+		{
+			std::this_thread::yield();
+		}
+
+		for (auto task = mFinished.exchange(nullptr, std::memory_order_acquire); task; )
+		{
+			auto next = task->mNext;
+			task->mDiscard(task);
+			task = next;
+		}
+	}
+
+	LightDispatcher& LightDispatcher::current()
+	{
+		thread_local LightDispatcher dispatcher;
+		return dispatcher;
+	}
+
+	void LightDispatcher::taskStarted()
+	{
+		mRunning.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void LightDispatcher::post(LightTaskBase* task)
+	{
+		auto head = mFinished.load(std::memory_order_relaxed);
+		do
+		{
+			task->mNext = head;
+		}
+		while (!mFinished.compare_exchange_weak(head, task, std::memory_order_release, std::memory_order_relaxed));
+
+		// the event of a non-empty stack is still pending, and completes this task as well
+		if (!head)
+		{
+			QCoreApplication::postEvent(this, new QEvent(FINISHED_EVENT));
+		}
+
+		// the last access of the worker - the destructor may proceed once the count drops to zero
+		mRunning.fetch_sub(1, std::memory_order_release);
+	}
+
+	bool LightDispatcher::event(QEvent* event)
+	{
+		if (event->type() != FINISHED_EVENT)
+		{
+			return QObject::event(event);
+		}
+
+		// the stack holds the most recently finished task first - reverse it, to complete the tasks in order
+		LightTaskBase* finished = nullptr;
+		for (auto task = mFinished.exchange(nullptr, std::memory_order_acquire); task; )
+		{
+			auto next = task->mNext;
+			task->mNext = finished;
+			finished = task;
+			task = next;
+		}
+
+		while (finished)
+		{
+			auto task = finished;
+			finished = finished->mNext;
+			task->mComplete(task);
+		}
+
+		return true;
+	}
+
+	Executor& default_executor()
+	{
+		static ThreadPoolExecutor executor;
+		return executor;
+	}
+}
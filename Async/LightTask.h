@@ -0,0 +1,493 @@
+#pragma once
+
+#include "Async.h"
+#include "Executor.h"
+#include "InplaceFunction.h"
+#include "TypeTraits.h"
+#include "FooGlobal.h"
+
+#include <QEvent>
+#include <QObject>
+#include <QThread>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace foo::async
+{
+	namespace detail
+	{
+		/**
+		 * Shared state of a light task, as seen by the LightDispatcher
+		 *
+		 * The worker running the task links the finished state into the continuation slot of the thread which started it
+		 * (mNext is the link), and the dispatcher of that thread then calls mComplete - or mDiscard, if the thread exits
+		 * before.
+		 */
+		struct LightTaskBase
+		{
+			LightTaskBase*	mNext							= nullptr;
+			void			(*mComplete)(LightTaskBase*)	= nullptr;
+			void			(*mDiscard)(LightTaskBase*)		= nullptr;
+		};
+
+		/**
+		 * Delivers the finished light tasks to the thread that started them - one per thread (created on first use)
+		 *
+		 * The workers push the finished states onto an atomic lock-free stack, and only the push onto an empty stack posts
+		 * an event, so a burst of tasks finishing together is delivered by a single event.
+		 *
+		 * When the thread exits, the destructor waits for the tasks still running and discards them (without callbacks).
+		 */
+		class FOOSHARED_EXPORT LightDispatcher : public QObject
+		{
+		public:
+			~LightDispatcher() override;
+
+			/** The dispatcher of the calling thread */
+			static LightDispatcher& current();
+
+			/** Counts a task started on the thread of this dispatcher, which is going to be post()-ed */
+			void taskStarted();
+
+			/** Queues the finished \a task to be completed on the thread of this dispatcher - callable from any thread */
+			void post(LightTaskBase* task);
+
+			bool event(QEvent* event) override;
+
+		private:
+			std::atomic<LightTaskBase*>	mFinished	= nullptr;
+			std::atomic<size_t>			mRunning	= 0;
+		};
+
+		/** The executor of the light tasks which do not have one set - the global QThreadPool */
+		FOOSHARED_EXPORT Executor& default_executor();
+
+		/**
+		 * Free list of the memory blocks for a T, per thread
+		 *
+		 * Light tasks are allocated and freed on the thread which started them, so the list needs no synchronization.
+		 */
+		template <typename T>
+		class ThreadLocalPool
+		{
+		public:
+			static void* allocate()
+			{
+				auto& free_list = freeList();
+				if (free_list.mHead)
+				{
+					auto block = free_list.mHead;
+					free_list.mHead = block->mNext;
+					--free_list.mCount;
+					return block;
+				}
+				return ::operator new(sizeof(Block));
+			}
+
+			static void deallocate(void* pointer)
+			{
+				auto& free_list = freeList();
+				if (free_list.mCount >= MAX_FREE_BLOCKS)
+				{
+					::operator delete(pointer);
+					return;
+				}
+				auto block = static_cast<Block*>(pointer);
+				block->mNext = free_list.mHead;
+				free_list.mHead = block;
+				++free_list.mCount;
+			}
+
+		private:
+			/** Upper bound of the kept blocks, so that a burst of tasks does not pin its memory */
+			static constexpr size_t MAX_FREE_BLOCKS = 4096;
+
+			union Block
+			{
+				Block*							mNext;
+				alignas(T) std::byte			mStorage[sizeof(T)];
+			};
+
+			struct FreeList
+			{
+				~FreeList()
+				{
+					while (mHead)
+					{
+						::operator delete(std::exchange(mHead, mHead->mNext));
+					}
+				}
+
+				Block*	mHead	= nullptr;
+				size_t	mCount	= 0;
+			};
+
+			static FreeList& freeList()
+			{
+				thread_local FreeList free_list;
+				return free_list;
+			}
+		};
+
+		/**
+		 * The callbacks of a light task - onDone() (of the result, or of the value of an Expected) and onError()
+		 */
+		template <typename ResultType, typename Enabled = void>
+		struct LightCallbacks
+		{
+			using SuccessType = ResultType;
+
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
+			{
+				if constexpr (traits::IsCallable_v<CallbackType, ResultType>)
+				{
+					mSuccess = [callback = std::forward<CallbackType>(callback)](ResultType& result) { callback(std::move(result)); };
+				}
+				else
+				{
+					mSuccess = [callback = std::forward<CallbackType>(callback)](ResultType&) { callback(); };
+				}
+			}
+
+			template <typename CallbackType>
+			void onError(CallbackType&&)
+			{
+				// generic implementation does nothing
+			}
+
+			/** @returns whether the task succeeded */
+			bool deliver(ResultType& result)
+			{
+				if (mSuccess)
+				{
+					mSuccess(result);
+				}
+				return true;
+			}
+
+			inplace_function<void(ResultType&), CALLBACK_CAPACITY> mSuccess;
+		};
+
+		template <>
+		struct LightCallbacks<void>
+		{
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
+			{
+				mSuccess = std::forward<CallbackType>(callback);
+			}
+
+			template <typename CallbackType>
+			void onError(CallbackType&&)
+			{
+			}
+
+			bool deliver()
+			{
+				if (mSuccess)
+				{
+					mSuccess();
+				}
+				return true;
+			}
+
+			inplace_function<void(), CALLBACK_CAPACITY> mSuccess;
+		};
+
+		template <typename ResultType>
+		struct LightCallbacks<ResultType, std::enable_if_t<traits::IsSpecializationOf_v<Expected, ResultType>>>
+		{
+			using SuccessType = typename ResultType::ValueType;
+			using FailureType = typename ResultType::ErrorType;
+
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
+			{
+				mSuccess = std::forward<CallbackType>(callback);
+			}
+
+			template <typename CallbackType>
+			void onError(CallbackType&& callback)
+			{
+				mFailure = std::forward<CallbackType>(callback);
+			}
+
+			bool deliver(ResultType& result)
+			{
+				if (result.isValid())
+				{
+					if (mSuccess)
+					{
+						mSuccess(result.value());
+					}
+					return true;
+				}
+
+				if (mFailure)
+				{
+					mFailure(result.error());
+				}
+				return false;
+			}
+
+			inplace_function<void(SuccessType), CALLBACK_CAPACITY> mSuccess;
+			inplace_function<void(FailureType), CALLBACK_CAPACITY> mFailure;
+		};
+
+		/**
+		 * The shared state of a running light task - allocated from the ThreadLocalPool of the starting thread,
+		 * written by the worker (the result) and freed on the starting thread once the callbacks ran
+		 */
+		template <typename ResultType, typename Function>
+		class LightTask : public LightTaskBase
+		{
+		public:
+			using Pool = ThreadLocalPool<LightTask>;
+
+			/** The \a owner (if any) is finished once the callbacks ran, and its \a trace (if any) is stamped */
+			static void start(Function&& function, LightCallbacks<ResultType>&& callbacks, Executor& executor, AbstractTask* owner, TraceSpan* trace)
+			{
+				Q_ASSERT_X(QThread::currentThread()->eventDispatcher(), "foo::async::light_task",
+						   "light tasks deliver their results by events, so they must be started on a thread with an event loop");
+
+				auto task = ::new (Pool::allocate()) LightTask(std::move(function), std::move(callbacks), owner, trace);
+				executor.post([task] { task->run(); });
+			}
+
+		private:
+			LightTask(Function&& function, LightCallbacks<ResultType>&& callbacks, AbstractTask* owner, TraceSpan* trace)
+				: mFunction(std::move(function))
+				, mCallbacks(std::move(callbacks))
+				, mOrigin(&LightDispatcher::current())
+				, mOwner(owner)
+				, mTrace(trace)
+			{
+				mComplete = &LightTask::complete;
+				mDiscard = &LightTask::discard;
+				mOrigin->taskStarted();
+			}
+
+			void run()
+			{
+				{
+					TraceRunScope trace_scope(mTrace);
+					if (!mOwner)
+					{
+						compute();
+					}
+					else if (const auto& token = mOwner->cancellationToken(); !token.isCancelled())
+					{
+						CancellationScope scope(token);
+						compute();
+					}
+				}
+				mOrigin->post(this);
+			}
+
+			void compute()
+			{
+				if constexpr (std::is_void_v<ResultType>)
+				{
+					mFunction();
+				}
+				else
+				{
+					mResult.emplace(mFunction());
+				}
+				mComputed = true;
+			}
+
+			static void complete(LightTaskBase* base)
+			{
+				auto task = static_cast<LightTask*>(base);
+				if (task->mTrace)
+				{
+					trace_callback(*task->mTrace);
+				}
+
+				// decided by whether the worker computed the result - the token may not be cancelled anymore (e.g. by
+				// a later setDeadline()), and the callbacks of a task cancelled after its work ran are not called either
+				bool success = false;
+				if (task->mComputed && (!task->mOwner || !task->mOwner->cancellationToken().isCancelled()))
+				{
+					if constexpr (std::is_void_v<ResultType>)
+					{
+						success = task->mCallbacks.deliver();
+					}
+					else
+					{
+						success = task->mCallbacks.deliver(*task->mResult);
+					}
+				}
+
+				auto owner = task->mOwner;
+				task->~LightTask();
+				Pool::deallocate(task);
+
+				if (owner)
+				{
+					owner->finishWith(success);
+				}
+			}
+
+			/** Frees the task of an exiting thread - not to its pool, as the thread-local pools may be destroyed already */
+			static void discard(LightTaskBase* base)
+			{
+				auto task = static_cast<LightTask*>(base);
+
+				auto owner = task->mOwner;
+				task->~LightTask();
+				::operator delete(static_cast<void*>(task));
+
+				if (owner)
+				{
+					owner->finishWith(false);
+				}
+			}
+
+			struct NoResult {};
+			using Result = std::conditional_t<std::is_void_v<ResultType>, NoResult, std::optional<ResultType>>;
+
+			Function					mFunction;
+			LightCallbacks<ResultType>	mCallbacks;
+			Result						mResult;
+			bool						mComputed	= false;
+			LightDispatcher*			mOrigin;
+			AbstractTask*				mOwner;
+			TraceSpan*					mTrace;
+		};
+
+		/**
+		 * AbstractTask running a light task - for weave()/queue() and the other compositions of AbstractTask
+		 */
+		template <typename ResultType, typename Function>
+		class LightTaskAdapter : public AbstractTask
+		{
+		public:
+			LightTaskAdapter(Function&& function, LightCallbacks<ResultType>&& callbacks)
+				: mFunction(std::move(function))
+				, mCallbacks(std::move(callbacks))
+			{
+				mTrace.mName = "light_task";
+			}
+
+			void start() override
+			{
+				trace_submit(mTrace);
+				LightTask<ResultType, Function>::start(std::move(mFunction), std::move(mCallbacks), mExecutor ? *mExecutor : default_executor(), this, &mTrace);
+			}
+
+		private:
+			Function					mFunction;
+			LightCallbacks<ResultType>	mCallbacks;
+		};
+
+		/**
+		 * LightTaskBuilder - the TaskBuilder counterpart creating light tasks
+		 */
+		template <typename ResultType, typename Function>
+		class LightTaskBuilder
+		{
+		public:
+			LightTaskBuilder(Function&& function, Executor* executor)
+				: mFunction(std::move(function))
+				, mExecutor(executor)
+			{
+			}
+
+			template <typename CallbackType>
+			LightTaskBuilder& onDone(CallbackType&& callback)
+			{
+				mCallbacks.onDone(std::forward<CallbackType>(callback));
+				return *this;
+			}
+
+			template <typename CallbackType>
+			LightTaskBuilder& onError(CallbackType&& callback)
+			{
+				mCallbacks.onError(std::forward<CallbackType>(callback));
+				return *this;
+			}
+
+			/** Starts the task - the builder must not be used afterwards */
+			void start()
+			{
+				LightTask<ResultType, Function>::start(std::move(mFunction), std::move(mCallbacks), mExecutor ? *mExecutor : default_executor(), nullptr, nullptr);
+			}
+
+			/**
+			 * The task as an AbstractTask, to be composed with weave()/queue() (or started by start())
+			 *
+			 * @note This allocates the QObject the light task otherwise avoids - the builder must not be used afterwards
+			 */
+			AbstractTask* get()
+			{
+				auto task = new LightTaskAdapter<ResultType, Function>(std::move(mFunction), std::move(mCallbacks));
+				task->setExecutor(mExecutor);
+				return task;
+			}
+
+		private:
+			Function					mFunction;
+			LightCallbacks<ResultType>	mCallbacks;
+			Executor*					mExecutor;
+		};
+
+		template <typename Function, typename... Args>
+		auto make_light_task(Executor* executor, Function&& function, Args&&... args)
+		{
+			using ResultType = std::decay_t<std::invoke_result_t<const std::decay_t<Function>&, const std::decay_t<Args>&...>>;
+
+			auto invocation = [function = std::forward<Function>(function), args...]() -> ResultType
+			{
+				return std::invoke(function, args...);
+			};
+			return LightTaskBuilder<ResultType, decltype(invocation)>{ std::move(invocation), executor };
+		}
+	}
+
+
+	/**
+	 * @brief Creates a light task - the counterpart of task() for fine-grained work, where a QObject, a QFutureWatcher
+	 * and the signal/slot connections per task would cost more than the work itself
+	 *
+	 * The task is a pool allocated state, the worker hands the result back to the starting thread (batched, by a single
+	 * event per burst of finished tasks) and there the callbacks run, with the same onDone()/onError() API as task().
+	 *
+	 * @example:
+	 *
+		for (const auto& tile : tiles)
+		{
+			foo::async::light_task(render, tile)
+				.onDone([this](const QImage& image) { mCanvas.paint(image); })
+				.start();
+		}
+
+	 * @note The function must not throw (there is no QFuture to hold the exception), and a single onDone() and onError()
+	 * callback is kept. Use get() to compose light tasks with weave()/queue().
+	 *
+	 * @note The starting thread must run an event loop (asserted), which delivers the results. The tasks still pending
+	 * when it exits are waited for and discarded, without their callbacks.
+	 */
+	template <typename Function, typename... Args, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Function>>>
+	auto light_task(Function&& function, Args&&... args)
+	{
+		return detail::make_light_task(nullptr, std::forward<Function>(function), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief Creates a light task running on the given \a executor, @see light_task(Function&&, Args&&...)
+	 */
+	template <typename Function, typename... Args>
+	auto light_task(Executor& executor, Function&& function, Args&&... args)
+	{
+		return detail::make_light_task(&executor, std::forward<Function>(function), std::forward<Args>(args)...);
+	}
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "Async.h"
+
+#include <QVector>
+
+#include <algorithm>
+#include <initializer_list>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace foo::async
+{
+	/**
+	 * @brief Runs tasks with dependencies between them - each task starts as soon as all its predecessors succeeded
+	 *
+	 * The predecessors of a task are the nodes added before it, so the graph cannot have cycles. Of the tasks ready
+	 * to start, the ones with the longest (by cost) path of successors ahead of them are started first, so that the
+	 * critical path does not wait behind the short branches.
+	 *
+	 * The graph finishes like any AbstractTask: successfully once all the tasks succeeded, unsuccessfully as soon as
+	 * any task fails - the running tasks are cancelled then, and the rest is never started.
+	 *
+	 * @example: (a diamond - compile and docs both need fetch, package needs both)
+	 *
+		auto graph = new foo::async::TaskGraph;
+		const auto fetch = graph->add(foo::async::task(fetch_sources).get());
+		const auto compile = graph->add(foo::async::task(compile_sources).get(), { fetch }, 10);
+		const auto docs = graph->add(foo::async::task(generate_docs).get(), { fetch });
+		graph->add(foo::async::task(package).get(), { compile, docs });
+
+		QObject::connect(graph, &foo::async::AbstractTask::finished, [](bool success) { qDebug() << "built:" << success; });
+		graph->start();
+
+	 * @note The graph owns the added tasks from then on, like weave() and queue()
+	 */
+	class TaskGraph : public AbstractTask
+	{
+	public:
+		/** Handle of a task added to the graph */
+		using Node = int;
+
+		TaskGraph()
+		{
+			mTrace.mName = "graph";
+		}
+
+		/**
+		 * Adds the \a task, to be started once all the \a predecessors succeeded
+		 *
+		 * @param cost relative estimate of the duration of the task, for the critical path ordering
+		 * @returns the node of the task, to be used as a predecessor of the later added tasks
+		 *
+		 * @note Tasks cannot be added once the graph started - the finished predecessors would never release them
+		 */
+		Node add(AbstractTask* task, std::initializer_list<Node> predecessors = {}, double cost = 1)
+		{
+			return add(task, QVector<Node>(predecessors), cost);
+		}
+
+		Node add(AbstractTask* task, const QVector<Node>& predecessors, double cost = 1)
+		{
+			Q_ASSERT_X(!mGraphStarted, "foo::async::TaskGraph::add", "tasks cannot be added once the graph started");
+
+			const Node node = static_cast<Node>(mVertices.size());
+
+			Vertex vertex;
+			vertex.mTask = task;
+			vertex.mCost = cost;
+			for (auto predecessor : predecessors)
+			{
+				Q_ASSERT(predecessor >= 0 && predecessor < node);
+				mVertices[predecessor].mSuccessors.append(node);
+				++vertex.mPendingInputs;
+			}
+			mVertices.push_back(std::move(vertex));
+
+			task->cancellationToken().linkTo(mToken);
+			if (mExecutor && !task->executor())
+			{
+				task->setExecutor(mExecutor);
+			}
+
+			connect(task, &AbstractTask::finished, this, [this, node](bool success)
+			{
+				onFinished(node, success);
+			});
+
+			return node;
+		}
+
+		/** Limits the number of the tasks running at once (unlimited by default) */
+		void setMaxInFlight(int max_in_flight)
+		{
+			mMaxInFlight = std::max(max_in_flight, 1);
+		}
+
+		void start() override
+		{
+			detail::trace_submit(mTrace);
+			mGraphStarted = true;
+			if (mVertices.empty())
+			{
+				finishWith(true);
+				return;
+			}
+
+			// the predecessors precede each node, so walking backwards sees the successors first
+			for (auto vertex = mVertices.rbegin(); vertex != mVertices.rend(); ++vertex)
+			{
+				double longest_successor = 0;
+				for (auto successor : vertex->mSuccessors)
+				{
+					longest_successor = std::max(longest_successor, mVertices[successor].mPriority);
+				}
+				vertex->mPriority = vertex->mCost + longest_successor;
+			}
+
+			for (Node node = 0; node < static_cast<Node>(mVertices.size()); ++node)
+			{
+				if (mVertices[node].mPendingInputs == 0)
+				{
+					mReady.push({ mVertices[node].mPriority, node });
+				}
+			}
+
+			startReady();
+		}
+
+		/** The \a executor of the graph applies to its tasks, which do not have an executor of their own */
+		void setExecutor(Executor* executor) override
+		{
+			AbstractTask::setExecutor(executor);
+			for (auto& vertex : mVertices)
+			{
+				if (!vertex.mTask->executor())
+				{
+					vertex.mTask->setExecutor(executor);
+				}
+			}
+		}
+
+	private:
+		struct Vertex
+		{
+			AbstractTask*	mTask			= nullptr;
+			QVector<Node>	mSuccessors;
+			int				mPendingInputs	= 0;
+			double			mCost			= 1;
+			double			mPriority		= 0;
+			bool			mStarted		= false;
+		};
+
+		void startReady()
+		{
+			// a task finishing within its start() may finish the graph as well (and delete the tasks not started yet)
+			while (!mFinished && !mReady.empty() && mInFlight < mMaxInFlight)
+			{
+				const auto node = mReady.top().second;
+				mReady.pop();
+
+				++mInFlight;
+				mVertices[node].mStarted = true;
+				mVertices[node].mTask->start();
+			}
+		}
+
+		void onFinished(Node node, bool success)
+		{
+			if (mFinished)
+			{
+				return;
+			}
+			--mInFlight;
+
+			if (!success || mToken.isCancelled())
+			{
+				// the result is known - stop the running tasks, and drop the ones never started
+				mToken.cancel();
+				for (auto& vertex : mVertices)
+				{
+					if (!vertex.mStarted)
+					{
+						vertex.mTask->deleteLater();
+					}
+				}
+				finishWith(false);
+				return;
+			}
+
+			if (++mSucceededCount == static_cast<int>(mVertices.size()))
+			{
+				finishWith(true);
+				return;
+			}
+
+			for (auto successor : mVertices[node].mSuccessors)
+			{
+				if (--mVertices[successor].mPendingInputs == 0)
+				{
+					mReady.push({ mVertices[successor].mPriority, successor });
+				}
+			}
+			startReady();
+		}
+
+		std::vector<Vertex>								mVertices;
+		std::priority_queue<std::pair<double, Node>>	mReady;
+		int												mMaxInFlight	= std::numeric_limits<int>::max();
+		int												mInFlight		= 0;
+		int												mSucceededCount	= 0;
+		bool											mGraphStarted	= false;
+	};
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "Async.h"
+#include "LightTask.h"
+
+#include <QDebug>
+#include <QMetaObject>
+
+#include <exception>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace foo::async
+{
+	namespace detail
+	{
+		struct NoPipelineError {};
+
+		/** What a stage returning ResultType passes on - the value of an Expected, the result otherwise */
+		template <typename ResultType, typename Enabled = void>
+		struct StageOutput
+		{
+			using Value = ResultType;
+			using Error = NoPipelineError;
+		};
+
+		template <typename ResultType>
+		struct StageOutput<ResultType, std::enable_if_t<traits::IsSpecializationOf_v<Expected, ResultType>>>
+		{
+			using Value = typename ResultType::ValueType;
+			using Error = typename ResultType::ErrorType;
+		};
+
+		/** The result of a stage taking the Input (nothing for VOID) */
+		template <typename Stage, typename Input>
+		struct StageResult
+		{
+			using Type = std::invoke_result_t<Stage&, Input&&>;
+		};
+
+		template <typename Stage>
+		struct StageResult<Stage, void>
+		{
+			using Type = std::invoke_result_t<Stage&>;
+		};
+
+		/** The value passed out of the last of the Stages, and the error type of the Expected stages */
+		template <typename Input, typename Error, typename... Stages>
+		struct PipelineTypes
+		{
+			using Value = Input;
+			using ErrorType = Error;
+		};
+
+		template <typename Input, typename Error, typename Stage, typename... Stages>
+		struct PipelineTypes<Input, Error, Stage, Stages...>
+		{
+			using Output = StageOutput<std::decay_t<typename StageResult<Stage, Input>::Type>>;
+
+			static_assert(std::is_same_v<Error, NoPipelineError> || std::is_same_v<typename Output::Error, NoPipelineError> || std::is_same_v<Error, typename Output::Error>,
+						  "foo::async::pipeline: the stages returning Expected must have the same error type");
+
+			using Next = PipelineTypes<typename Output::Value,
+									   std::conditional_t<std::is_same_v<Error, NoPipelineError>, typename Output::Error, Error>,
+									   Stages...>;
+			using Value = typename Next::Value;
+			using ErrorType = typename Next::ErrorType;
+		};
+
+		/**
+		 * PipelineTask - runs its stages one after another in a single job on the executor, each stage receiving the result
+		 * of the previous one by move (so move-only results pass through, and nothing is copied)
+		 *
+		 * An Expected result is unpacked for the next stage - its error ends the pipeline, and goes to onError().
+		 * The final value is moved to the onDone() callback, on the thread the task was created on.
+		 */
+		template <typename... Stages>
+		class PipelineTask : public AbstractTask
+		{
+		public:
+			using Types = PipelineTypes<void, NoPipelineError, Stages...>;
+			using ValueType = typename Types::Value;
+			using ErrorType = typename Types::ErrorType;
+
+			explicit PipelineTask(Stages&&... stages)
+				: mStages(std::move(stages)...)
+			{
+				mTrace.mName = "pipeline";
+			}
+
+			template <typename CallbackType>
+			void onDone(CallbackType&& callback)
+			{
+				mCallbacks.onDone(std::forward<CallbackType>(callback));
+			}
+
+			template <typename CallbackType>
+			void onError(CallbackType&& callback)
+			{
+				if constexpr (!std::is_same_v<ErrorType, NoPipelineError>)
+				{
+					mFailureCallback = std::forward<CallbackType>(callback);
+				}
+			}
+
+			void start() override
+			{
+				detail::trace_submit(mTrace);
+
+				auto& executor = mExecutor ? *mExecutor : default_executor();
+				executor.post([this]
+				{
+					{
+						TraceRunScope trace_scope(&mTrace);
+						CancellationScope scope(mToken);
+						try
+						{
+							runFrom<0>();
+						}
+						catch (...)
+						{
+							mException = std::current_exception();
+						}
+					}
+
+					QMetaObject::invokeMethod(this, [this] { complete(); }, Qt::QueuedConnection);
+				});
+			}
+
+		private:
+			template <size_t Index, typename... Input>
+			void runFrom(Input&&... input)
+			{
+				if constexpr (Index == sizeof...(Stages))
+				{
+					if constexpr (sizeof...(Input) == 0)
+					{
+						mValue.emplace(true);
+					}
+					else
+					{
+						mValue.emplace(std::forward<Input>(input)...);
+					}
+				}
+				else
+				{
+					if (mToken.isCancelled())
+					{
+						return;
+					}
+
+					auto& stage = std::get<Index>(mStages);
+					using Result = std::invoke_result_t<decltype(stage), Input&&...>;
+
+					if constexpr (std::is_void_v<Result>)
+					{
+						std::invoke(stage, std::forward<Input>(input)...);
+						runFrom<Index + 1>();
+					}
+					else if constexpr (traits::IsSpecializationOf_v<Expected, std::decay_t<Result>>)
+					{
+						auto result = std::invoke(stage, std::forward<Input>(input)...);
+						if (!result.isValid())
+						{
+							mError.emplace(result.error());
+							return;
+						}
+						runFrom<Index + 1>(std::move(result.value()));
+					}
+					else
+					{
+						runFrom<Index + 1>(std::invoke(stage, std::forward<Input>(input)...));
+					}
+				}
+			}
+
+			void complete()
+			{
+				trace_callback(mTrace);
+
+				if (mException)
+				{
+					warnException();
+					finishWith(false);
+					return;
+				}
+
+				// cancelled - by what the worker did (the remaining stages were skipped, even if the token is not cancelled
+				// anymore, e.g. by a later setDeadline()), or after the last stage ran, which skips the callbacks as well
+				if (!(mValue || mError) || mToken.isCancelled())
+				{
+					finishWith(false);
+					return;
+				}
+
+				if constexpr (!std::is_same_v<ErrorType, NoPipelineError>)
+				{
+					if (mError)
+					{
+						if (mFailureCallback)
+						{
+							mFailureCallback(std::move(*mError));
+						}
+						finishWith(false);
+						return;
+					}
+				}
+
+				if constexpr (std::is_void_v<ValueType>)
+				{
+					mCallbacks.deliver();
+				}
+				else
+				{
+					mCallbacks.deliver(*mValue);
+				}
+				finishWith(true);
+			}
+
+			/** A stage threw - there is no callback taking the exception, so it is reported */
+			void warnException() const
+			{
+				try
+				{
+					std::rethrow_exception(mException);
+				}
+				catch (const TaskCancelled&)
+				{
+				}
+				catch (const std::exception& error)
+				{
+					qWarning() << "foo::async::pipeline: a stage threw:" << error.what();
+				}
+				catch (...)
+				{
+					qWarning() << "foo::async::pipeline: a stage threw an unknown exception";
+				}
+			}
+
+			using Value = std::conditional_t<std::is_void_v<ValueType>, bool, ValueType>;
+			using FailureCallback = std::conditional_t<std::is_same_v<ErrorType, NoPipelineError>,
+													   NoPipelineError,
+													   inplace_function<void(ErrorType), CALLBACK_CAPACITY>>;
+
+			std::tuple<Stages...>		mStages;
+			LightCallbacks<ValueType>	mCallbacks;
+			FailureCallback				mFailureCallback;
+			std::optional<Value>		mValue;
+			std::optional<ErrorType>	mError;
+		};
+
+		/**
+		 * PipelineBuilder - the TaskBuilder counterpart for pipeline()
+		 */
+		template <typename Task>
+		class PipelineBuilder
+		{
+		public:
+			explicit PipelineBuilder(Task* task)
+				: mTask(task)
+			{
+			}
+
+			template <typename CallbackType>
+			PipelineBuilder& onDone(CallbackType&& callback)
+			{
+				mTask->onDone(std::forward<CallbackType>(callback));
+				return *this;
+			}
+
+			template <typename CallbackType>
+			PipelineBuilder& onError(CallbackType&& callback)
+			{
+				mTask->onError(std::forward<CallbackType>(callback));
+				return *this;
+			}
+
+			/** Names the task in the Tracer, @see AbstractTask::setTraceName() */
+			PipelineBuilder& named(const char* name)
+			{
+				mTask->setTraceName(name);
+				return *this;
+			}
+
+			AbstractTask* get()
+			{
+				return mTask;
+			}
+
+		private:
+			Task* mTask;
+		};
+	}
+
+
+	/**
+	 * @brief Creates a task running the \a stages one after another, each one taking the result of the previous one
+	 *
+	 * Unlike a queue() of tasks, the results are typed and passed by move - they can be move-only (std::unique_ptr,
+	 * large buffers), and they are never copied on the way. The stages run in a single job, on the executor of the task
+	 * (the global QThreadPool by default), and only the final value comes back to the thread the task was created on.
+	 *
+	 * Stages returning Expected<T, E> pass T on, and end the pipeline by an error - the onError() callback then gets it.
+	 *
+	 * @example:
+	 *
+		foo::async::pipeline(
+				[path] { return read_file(path); },                                        // Expected<QByteArray, std::error_code>
+				[](QByteArray data) { return std::make_unique<Document>(parse(data)); },
+				[](std::unique_ptr<Document> document) { document->index(); return document; })
+			.onDone([this](std::unique_ptr<Document> document) { mDocuments.push_back(std::move(document)); })
+			.onError([](std::error_code error) { qDebug() << "error:" << error.value(); })
+			.get()->start();
+
+	 * @note The Expected stages must share one error type. A stage throwing ends the pipeline unsuccessfully, without
+	 * the callbacks - the exception is reported by qWarning().
+	 *
+	 * @note The stages are plain callables, all run on the one executor of the pipeline - not tasks. A queue() still
+	 * passes only the success on, and task() still copies its result to each onDone() callback.
+	 */
+	template <typename... Stages, typename = std::enable_if_t<!detail::StartsWithExecutor_v<Stages...>>>
+	auto pipeline(Stages&&... stages)
+	{
+		static_assert(sizeof...(Stages) > 0, "foo::async::pipeline: at least one stage is needed");
+
+		using Task = detail::PipelineTask<std::decay_t<Stages>...>;
+		return detail::PipelineBuilder<Task>{ new Task(std::decay_t<Stages>(std::forward<Stages>(stages))...) };
+	}
+
+	/**
+	 * pipeline() running on the given \a executor
+	 */
+	template <typename... Stages>
+	auto pipeline(Executor& executor, Stages&&... stages)
+	{
+		auto builder = pipeline(std::forward<Stages>(stages)...);
+		builder.get()->setExecutor(&executor);
+		return builder;
+	}
+}
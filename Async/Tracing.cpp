@@ -0,0 +1,219 @@
+#include "Tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	using Clock = foo::async::Tracer::Clock;
+
+	/** Name of the tasks which were not named() */
+	constexpr const char* UNNAMED = "task";
+
+	const char* name_of(const foo::async::detail::TraceSpan& span)
+	{
+		return span.mName ? span.mName : UNNAMED;
+	}
+
+	bool is_stamped(Clock::time_point time)
+	{
+		return time != Clock::time_point{};
+	}
+
+	double microseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::micro>(duration).count();
+	}
+
+	double timestamp(Clock::time_point time)
+	{
+		return microseconds(time.time_since_epoch());
+	}
+
+	void write_json_string(std::ostream& output, const char* text)
+	{
+		output << '"';
+		for (auto character = text; *character; ++character)
+		{
+			switch (*character)
+			{
+				case '"':	output << "\\\"";	break;
+				case '\\':	output << "\\\\";	break;
+				case '\n':	output << "\\n";	break;
+				case '\t':	output << "\\t";	break;
+				default:
+					if (static_cast<unsigned char>(*character) >= 0x20)
+					{
+						output << *character;
+					}
+			}
+		}
+		output << '"';
+	}
+}
+
+namespace foo::async
+{
+	std::atomic<bool> Tracer::sEnabled = false;
+
+	void LatencyHistogram::add(Duration duration)
+	{
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+
+		size_t bucket = 0;
+		for (auto value = us; value > 1 && bucket + 1 < BUCKET_COUNT; value >>= 1)
+		{
+			++bucket;
+		}
+
+		++mBuckets[bucket];
+		++mCount;
+		mTotal += duration;
+	}
+
+	LatencyHistogram::Duration LatencyHistogram::percentile(double quantile) const
+	{
+		if (mCount == 0)
+		{
+			return Duration::zero();
+		}
+
+		const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(mCount)));
+
+		uint64_t seen = 0;
+		size_t bucket = 0;
+		for (; bucket + 1 < BUCKET_COUNT; ++bucket)
+		{
+			seen += mBuckets[bucket];
+			if (seen >= std::max<uint64_t>(rank, 1))
+			{
+				break;
+			}
+		}
+
+		return std::chrono::duration_cast<Duration>(std::chrono::microseconds(int64_t(1) << (bucket + 1)));
+	}
+
+	Tracer& Tracer::instance()
+	{
+		static Tracer tracer;
+		return tracer;
+	}
+
+	void Tracer::setEnabled(bool enabled)
+	{
+		sEnabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	uint32_t Tracer::currentThread()
+	{
+		static std::atomic<uint32_t> next_thread{ 1 };
+		thread_local const uint32_t thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+		return thread;
+	}
+
+	void Tracer::record(const detail::TraceSpan& span, Clock::time_point done)
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+
+		auto& latencies = mLatencies[name_of(span)];
+		if (is_stamped(span.mStart))
+		{
+			latencies.mQueueWait.add(span.mStart - span.mSubmit);
+		}
+		if (is_stamped(span.mStart) && is_stamped(span.mFinish))
+		{
+			latencies.mRun.add(span.mFinish - span.mStart);
+		}
+		if (is_stamped(span.mFinish) && is_stamped(span.mCallback))
+		{
+			latencies.mDelivery.add(span.mCallback - span.mFinish);
+		}
+		latencies.mTotal.add(done - span.mSubmit);
+
+		if (mSpans.size() < MAX_TRACED_SPANS)
+		{
+			mSpans.push_back({ span, done });
+		}
+	}
+
+	std::map<std::string, TaskLatencies> Tracer::latencies() const
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		return mLatencies;
+	}
+
+	void Tracer::writeChromeTrace(std::ostream& output) const
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+
+		const auto flags = output.flags();
+		const auto precision = output.precision();
+		output << std::fixed << std::setprecision(3);
+
+		// each task is an async slice (b/e) on the thread that started it, as they overlap there,
+		// and its work is a complete slice (X) on the worker which ran it
+		output << "{\"traceEvents\":[";
+		bool first = true;
+		auto begin_event = [&output, &first](const detail::TraceSpan& span)
+		{
+			output << (first ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(output, name_of(span));
+			first = false;
+		};
+
+		for (size_t id = 0; id < mSpans.size(); ++id)
+		{
+			const auto& [span, done] = mSpans[id];
+
+			begin_event(span);
+			output << ",\"cat\":\"task\",\"ph\":\"b\",\"id\":" << id << ",\"pid\":1,\"tid\":" << span.mThread
+				   << ",\"ts\":" << timestamp(span.mSubmit) << ",\"args\":{";
+			if (is_stamped(span.mStart))
+			{
+				output << "\"queue_wait_us\":" << microseconds(span.mStart - span.mSubmit) << ',';
+			}
+			if (is_stamped(span.mFinish) && is_stamped(span.mCallback))
+			{
+				output << "\"delivery_us\":" << microseconds(span.mCallback - span.mFinish) << ',';
+			}
+			output << "\"total_us\":" << microseconds(done - span.mSubmit) << "}}";
+
+			begin_event(span);
+			output << ",\"cat\":\"task\",\"ph\":\"e\",\"id\":" << id << ",\"pid\":1,\"tid\":" << span.mThread
+				   << ",\"ts\":" << timestamp(done) << '}';
+
+			if (is_stamped(span.mStart) && is_stamped(span.mFinish))
+			{
+				begin_event(span);
+				output << ",\"cat\":\"run\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.mWorkerThread
+					   << ",\"ts\":" << timestamp(span.mStart) << ",\"dur\":" << microseconds(span.mFinish - span.mStart) << '}';
+			}
+		}
+		output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		output.flags(flags);
+		output.precision(precision);
+	}
+
+	bool Tracer::writeChromeTrace(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+
+		writeChromeTrace(file);
+		return static_cast<bool>(file);
+	}
+
+	void Tracer::clear()
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		mSpans.clear();
+		mLatencies.clear();
+	}
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "FooGlobal.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace foo::async
+{
+	namespace detail
+	{
+		/**
+		 * Timestamps of a task - stamped only when the task was started while tracing was enabled (mActive)
+		 *
+		 * mStart and mFinish are stamped by the worker running the work, the others on the thread of the task.
+		 */
+		struct TraceSpan
+		{
+			using Clock = std::chrono::steady_clock;
+
+			const char*			mName			= nullptr;
+			Clock::time_point	mSubmit;
+			Clock::time_point	mStart;
+			Clock::time_point	mFinish;
+			Clock::time_point	mCallback;
+			uint32_t			mThread			= 0;
+			uint32_t			mWorkerThread	= 0;
+			bool				mActive			= false;
+		};
+	}
+
+	/**
+	 * @brief Histogram of durations, in power of two buckets of microseconds
+	 */
+	class FOOSHARED_EXPORT LatencyHistogram
+	{
+	public:
+		using Duration = std::chrono::steady_clock::duration;
+
+		/** Bucket i holds the durations in [2^i, 2^(i+1)) us - the first one also the ones below 1 us */
+		static constexpr size_t BUCKET_COUNT = 32;
+
+		void add(Duration duration);
+
+		uint64_t count() const
+		{
+			return mCount;
+		}
+
+		Duration total() const
+		{
+			return mTotal;
+		}
+
+		/** Upper bound of the bucket holding the \a quantile (0..1), e.g. 0.99 for the 99th percentile */
+		Duration percentile(double quantile) const;
+
+		const std::array<uint64_t, BUCKET_COUNT>& buckets() const
+		{
+			return mBuckets;
+		}
+
+	private:
+		std::array<uint64_t, BUCKET_COUNT>	mBuckets	= {};
+		uint64_t							mCount		= 0;
+		Duration							mTotal		= Duration::zero();
+	};
+
+	/**
+	 * @brief Latencies of the tasks of one name
+	 */
+	struct TaskLatencies
+	{
+		LatencyHistogram	mQueueWait;		///< from start() of the task to its work starting on a worker
+		LatencyHistogram	mRun;			///< the work on the worker
+		LatencyHistogram	mDelivery;		///< from the work finishing to its callbacks being called on the thread of the task
+		LatencyHistogram	mTotal;			///< from start() of the task to it finishing
+	};
+
+	/**
+	 * @brief Records the timestamps of the tasks (task(), weave(), queue() and the other compositions) - for the latency
+	 * histograms per task name, and a Chrome trace (chrome://tracing, or https://ui.perfetto.dev)
+	 *
+	 * Disabled by default, when the instrumentation costs one relaxed atomic load per task - so it can stay compiled in.
+	 *
+	 * @example:
+	 *
+		foo::async::Tracer::setEnabled(true);
+
+		foo::async::task(make_thumbnail, image).named("thumbnail").onDone(show).get()->start();
+		...
+		const auto latencies = foo::async::Tracer::instance().latencies();
+		qDebug() << "p99 thumbnail wait:" << latencies.at("thumbnail").mQueueWait.percentile(0.99).count();
+		foo::async::Tracer::instance().writeChromeTrace("tasks.json");
+
+	 * @note The names must outlive the tracer, i.e. are meant to be string literals
+	 */
+	class FOOSHARED_EXPORT Tracer
+	{
+	public:
+		using Clock = detail::TraceSpan::Clock;
+
+		static Tracer& instance();
+
+		static bool isEnabled()
+		{
+			return sEnabled.load(std::memory_order_relaxed);
+		}
+
+		static void setEnabled(bool enabled);
+
+		/** Small sequential id of the calling thread */
+		static uint32_t currentThread();
+
+		/** Records the \a span of a task, which finished at \a done */
+		void record(const detail::TraceSpan& span, Clock::time_point done);
+
+		/** The latencies per task name */
+		std::map<std::string, TaskLatencies> latencies() const;
+
+		/** Writes the recorded tasks in the Chrome trace event format (JSON) */
+		void writeChromeTrace(std::ostream& output) const;
+
+		/** @returns whether the file at \a path was written */
+		bool writeChromeTrace(const std::string& path) const;
+
+		void clear();
+
+	private:
+		/** Upper bound of the spans kept for the trace - the histograms keep counting beyond it */
+		static constexpr size_t MAX_TRACED_SPANS = size_t(1) << 20;
+
+		struct Span
+		{
+			detail::TraceSpan	mSpan;
+			Clock::time_point	mDone;
+		};
+
+		static std::atomic<bool>				sEnabled;
+
+		mutable std::mutex						mLock;
+		std::vector<Span>						mSpans;
+		std::map<std::string, TaskLatencies>	mLatencies;
+	};
+
+	namespace detail
+	{
+		/** Stamps the start() of a task - a no-op while tracing is disabled */
+		inline void trace_submit(TraceSpan& span)
+		{
+			if (Tracer::isEnabled())
+			{
+				span.mActive = true;
+				span.mSubmit = TraceSpan::Clock::now();
+				span.mThread = Tracer::currentThread();
+			}
+		}
+
+		/** Stamps the callbacks of a task about to be called */
+		inline void trace_callback(TraceSpan& span)
+		{
+			if (span.mActive)
+			{
+				span.mCallback = TraceSpan::Clock::now();
+			}
+		}
+
+		/** Records the finished task */
+		inline void trace_done(TraceSpan& span)
+		{
+			if (span.mActive)
+			{
+				span.mActive = false;
+				Tracer::instance().record(span, TraceSpan::Clock::now());
+			}
+		}
+
+		/**
+		 * Stamps the work of a task, for the scope of it on the worker - a no-op for a nullptr \a span
+		 */
+		class TraceRunScope
+		{
+		public:
+			explicit TraceRunScope(TraceSpan* span)
+				: mSpan(span && span->mActive ? span : nullptr)
+			{
+				if (mSpan)
+				{
+					mSpan->mWorkerThread = Tracer::currentThread();
+					mSpan->mStart = TraceSpan::Clock::now();
+				}
+			}
+
+			~TraceRunScope()
+			{
+				if (mSpan)
+				{
+					mSpan->mFinish = TraceSpan::Clock::now();
+				}
+			}
+
+			TraceRunScope(const TraceRunScope&) = delete;
+			TraceRunScope& operator=(const TraceRunScope&) = delete;
+
+		private:
+			TraceSpan* mSpan;
+		};
+	}
+}
@@ -0,0 +1,128 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	/** The pool (and the worker index in it) of the current thread, so that jobs posted from a worker stay local */
+	thread_local const foo::async::WorkStealingPool* tCurrentPool = nullptr;
+	thread_local size_t tCurrentWorker = 0;
+}
+
+namespace foo::async
+{
+	WorkStealingPool::WorkStealingPool(size_t thread_count)
+	{
+		thread_count = std::max<size_t>(thread_count, 1);
+
+		mWorkers.reserve(thread_count);
+		for (size_t index = 0; index < thread_count; ++index)
+		{
+			mWorkers.push_back(std::make_unique<Worker>());
+		}
+
+		mThreads.reserve(thread_count);
+		for (size_t index = 0; index < thread_count; ++index)
+		{
+			mThreads.emplace_back([this, index] { run(index); });
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mSleepLock);
+			mStopping = true;
+		}
+		mWakeUp.notify_all();
+
+		for (auto& thread : mThreads)
+		{
+			thread.join();
+		}
+	}
+
+	void WorkStealingPool::post(Job job)
+	{
+		const size_t index = tCurrentPool == this
+				? tCurrentWorker
+				: mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+
+		// counted before it can be taken (and uncounted), so that mPending never wraps around below zero
+		mPending.fetch_add(1);
+		{
+			std::lock_guard<std::mutex> lock(mWorkers[index]->mLock);
+			mWorkers[index]->mJobs.push_back(std::move(job));
+		}
+
+		// either a falling asleep worker sees the job, or this sees the worker (both are sequentially consistent),
+		// so no wake up is lost - while the busy pool is not slowed down by the sleep lock
+		if (mSleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(mSleepLock);
+			mWakeUp.notify_one();
+		}
+	}
+
+	size_t WorkStealingPool::threadCount() const
+	{
+		return mThreads.size();
+	}
+
+	void WorkStealingPool::run(size_t index)
+	{
+		tCurrentPool = this;
+		tCurrentWorker = index;
+
+		Job job;
+		while (true)
+		{
+			if (take(index, job))
+			{
+				mPending.fetch_sub(1);
+				job();
+				job = nullptr;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mSleepLock);
+			mSleeping.fetch_add(1);
+			mWakeUp.wait(lock, [this] { return mPending.load() > 0 || mStopping; });
+			mSleeping.fetch_sub(1);
+
+			// finish the remaining jobs before stopping
+			if (mStopping && mPending.load() == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	bool WorkStealingPool::take(size_t index, Job& job)
+	{
+		{
+			auto& own = *mWorkers[index];
+			std::lock_guard<std::mutex> lock(own.mLock);
+			if (!own.mJobs.empty())
+			{
+				job = std::move(own.mJobs.back());
+				own.mJobs.pop_back();
+				return true;
+			}
+		}
+
+		for (size_t offset = 1; offset < mWorkers.size(); ++offset)
+		{
+			auto& victim = *mWorkers[(index + offset) % mWorkers.size()];
+			std::lock_guard<std::mutex> lock(victim.mLock);
+			if (!victim.mJobs.empty())
+			{
+				job = std::move(victim.mJobs.front());
+				victim.mJobs.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
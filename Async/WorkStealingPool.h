@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Executor.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace foo::async
+{
+	/**
+	 * @brief Thread pool with a deque of jobs per worker
+	 *
+	 * A worker pushes the jobs it posts to (and takes its next job from) the back of its own deque, and when that is empty
+	 * it steals from the front of the others'. Jobs posted from other threads are spread over the workers round-robin.
+	 * So unlike a single shared queue, thousands of short jobs do not all contend for one lock.
+	 *
+	 * @note The destructor waits for all the posted jobs to finish
+	 */
+	class FOOSHARED_EXPORT WorkStealingPool : public Executor
+	{
+	public:
+		explicit WorkStealingPool(size_t thread_count = std::thread::hardware_concurrency());
+		~WorkStealingPool() override;
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		void post(Job job) override;
+
+		size_t threadCount() const;
+
+	private:
+		struct Worker
+		{
+			std::mutex			mLock;
+			std::deque<Job>		mJobs;
+		};
+
+		void run(size_t index);
+		bool take(size_t index, Job& job);
+
+		std::vector<std::unique_ptr<Worker>>	mWorkers;
+		std::vector<std::thread>				mThreads;
+
+		std::atomic<size_t>						mNextWorker	= 0;
+		std::atomic<size_t>						mPending	= 0;
+		std::atomic<size_t>						mSleeping	= 0;
+		std::atomic<bool>						mStopping	= false;
+
+		std::mutex								mSleepLock;
+		std::condition_variable					mWakeUp;
+	};
+}
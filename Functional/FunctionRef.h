@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace foo
+{
+	template <typename Signature>
+	class function_ref;
+
+	/**
+	 * Non-owning reference to a callable - a pointer to it plus a pointer to a call thunk, i.e. two words,
+	 * which never allocate and are trivially copied
+	 *
+	 * Meant for parameters of non-template functions that only call the callback during the call,
+	 * where std::function would be constructed (and possibly allocated) just to be invoked.
+	 *
+	 * @example:
+	 *  void for_each_row(foo::function_ref<void(const Row&)> visitor);
+	 *  for_each_row([&](const Row& row) { total += row.price; });
+	 *
+	 * @note The referred callable must outlive the function_ref, so it should not be stored
+	 */
+	template <typename R, typename... Args>
+	class function_ref<R(Args...)>
+	{
+	public:
+		template <typename F,
+				  typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, function_ref> && std::is_invocable_r_v<R, F&, Args...>>>
+		function_ref(F&& callable) noexcept
+		{
+			using Callable = std::remove_reference_t<F>;
+			using Function = std::remove_pointer_t<std::decay_t<F>>;
+
+			if constexpr (std::is_function_v<Function>)
+			{
+				// functions (and function pointers, which may be temporaries) are referred to by their address
+				Function* function = callable;
+				mCallable.function = reinterpret_cast<void (*)()>(function);
+				mThunk = [](Storage callable, Args... args) -> R
+				{
+					return static_cast<R>(std::invoke(reinterpret_cast<Function*>(callable.function), std::forward<Args>(args)...));
+				};
+			}
+			else
+			{
+				mCallable.object = const_cast<void*>(static_cast<const void*>(std::addressof(callable)));
+				mThunk = [](Storage callable, Args... args) -> R
+				{
+					return static_cast<R>(std::invoke(*static_cast<Callable*>(callable.object), std::forward<Args>(args)...));
+				};
+			}
+		}
+
+		R operator()(Args... args) const
+		{
+			return mThunk(mCallable, std::forward<Args>(args)...);
+		}
+
+	private:
+		union Storage
+		{
+			void*	object;
+			void	(*function)();
+		};
+
+		Storage	mCallable;
+		R		(*mThunk)(Storage, Args...);
+	};
+}
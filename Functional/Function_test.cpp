@@ -0,0 +1,80 @@
+#include <Foo/External/catch.hpp>
+
+#include <Foo/Core/FunctionRef.h>
+#include <Foo/Core/InplaceFunction.h>
+
+#include <memory>
+#include <string>
+
+namespace
+{
+	int twice(int i)
+	{
+		return i * 2;
+	}
+
+	int sum_of_first(int count, foo::function_ref<int(int)> element)
+	{
+		int sum = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			sum += element(i);
+		}
+		return sum;
+	}
+}
+
+TEST_CASE("inplace_function")
+{
+	SECTION("stores lambdas, function pointers and member pointers")
+	{
+		struct Element { int id; int doubled() const { return id * 2; } };
+
+		foo::inplace_function<int(int)> function = &twice;
+		foo::inplace_function<int(int)> lambda = [offset = 1](int i) { return i + offset; };
+		foo::inplace_function<int(const Element&)> member = &Element::id;
+		foo::inplace_function<int(const Element&)> getter = &Element::doubled;
+
+		CHECK(function(2) == 4);
+		CHECK(lambda(2) == 3);
+		CHECK(member(Element{ 5 }) == 5);
+		CHECK(getter(Element{ 5 }) == 10);
+	}
+
+	SECTION("copies and moves the captures")
+	{
+		auto counter = std::make_shared<int>(0);
+		foo::inplace_function<void(), 64> increment = [counter] { ++*counter; };
+
+		auto copy = increment;
+		auto moved = std::move(increment);
+		copy();
+		moved();
+
+		CHECK(*counter == 2);
+		CHECK(counter.use_count() == 3);
+		CHECK(!increment);
+
+		moved = nullptr;
+		CHECK(counter.use_count() == 2);
+	}
+
+	SECTION("empty functions throw when invoked")
+	{
+		foo::inplace_function<void()> empty;
+
+		CHECK(empty == nullptr);
+		CHECK_THROWS_AS(empty(), std::bad_function_call);
+	}
+}
+
+TEST_CASE("function_ref")
+{
+	int calls = 0;
+	auto element = [&calls](int i) { ++calls; return i; };
+
+	CHECK(sum_of_first(4, element) == 6);
+	CHECK(sum_of_first(4, &twice) == 12);
+	CHECK(sum_of_first(4, twice) == 12);
+	CHECK(calls == 4);
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace foo
+{
+	template <typename Signature, size_t Capacity = 32, size_t Alignment = alignof(std::max_align_t)>
+	class inplace_function;
+
+	namespace detail
+	{
+		template <typename T>
+		struct IsInplaceFunction : std::false_type {};
+
+		template <typename Signature, size_t Capacity, size_t Alignment>
+		struct IsInplaceFunction<inplace_function<Signature, Capacity, Alignment>> : std::true_type {};
+
+		/**
+		 * Operations on the callable stored in the buffer of an inplace_function - one static instance per callable type
+		 */
+		template <typename R, typename... Args>
+		struct InplaceVTable
+		{
+			R		(*invoke)(void* storage, Args&&... args);
+			void	(*copy)(const void* from, void* to);
+			void	(*move)(void* from, void* to);
+			void	(*destroy)(void* storage);
+		};
+
+		template <typename Callable, typename R, typename... Args>
+		inline constexpr InplaceVTable<R, Args...> VTABLE_FOR
+		{
+			[](void* storage, Args&&... args) -> R
+			{
+				if constexpr (std::is_void_v<R>)
+				{
+					std::invoke(*static_cast<Callable*>(storage), std::forward<Args>(args)...);
+				}
+				else
+				{
+					return std::invoke(*static_cast<Callable*>(storage), std::forward<Args>(args)...);
+				}
+			},
+			[](const void* from, void* to)
+			{
+				::new (to) Callable(*static_cast<const Callable*>(from));
+			},
+			[](void* from, void* to)
+			{
+				::new (to) Callable(std::move(*static_cast<Callable*>(from)));
+				static_cast<Callable*>(from)->~Callable();
+			},
+			[](void* storage)
+			{
+				static_cast<Callable*>(storage)->~Callable();
+			}
+		};
+	}
+
+	/**
+	 * Non-allocating replacement of std::function - the callable is always stored in an inline buffer of \a Capacity bytes
+	 *
+	 * Callables that do not fit are rejected at compile time (instead of silently going to the heap), so constructing,
+	 * copying and invoking never allocates. The call is a single indirect call through a per-type table.
+	 *
+	 * @example:
+	 *  foo::inplace_function<int(int)> twice = [](int i) { return i * 2; };
+	 *  foo::inplace_function<void(), 64> notify = [this, name]() { emit changed(name); };
+	 *
+	 * @note Like std::function, it requires the callable to be copyable, and invoking an empty one throws std::bad_function_call
+	 */
+	template <typename R, typename... Args, size_t Capacity, size_t Alignment>
+	class inplace_function<R(Args...), Capacity, Alignment>
+	{
+	public:
+		using VTable = detail::InplaceVTable<R, Args...>;
+
+		inplace_function() noexcept = default;
+
+		inplace_function(std::nullptr_t) noexcept
+		{
+		}
+
+		template <typename F,
+				  typename Callable = std::decay_t<F>,
+				  typename = std::enable_if_t<!detail::IsInplaceFunction<Callable>::value && std::is_invocable_r_v<R, Callable&, Args...>>>
+		inplace_function(F&& callable)
+		{
+			static_assert(sizeof(Callable) <= Capacity, "foo::inplace_function: the callable does not fit into the buffer - capture less, or increase the Capacity");
+			static_assert(Alignment % alignof(Callable) == 0, "foo::inplace_function: the callable needs a stricter Alignment");
+			static_assert(std::is_copy_constructible_v<Callable>, "foo::inplace_function: the callable must be copyable");
+
+			if constexpr (std::is_pointer_v<Callable> || std::is_member_pointer_v<Callable>)
+			{
+				if (callable == nullptr)
+				{
+					return;
+				}
+			}
+
+			::new (&mStorage) Callable(std::forward<F>(callable));
+			mVTable = &detail::VTABLE_FOR<Callable, R, Args...>;
+		}
+
+		/** Functions of a smaller capacity can be stored in a bigger one */
+		template <size_t OtherCapacity, size_t OtherAlignment,
+				  typename = std::enable_if_t<(OtherCapacity <= Capacity) && (Alignment % OtherAlignment == 0)>>
+		inplace_function(const inplace_function<R(Args...), OtherCapacity, OtherAlignment>& other)
+		{
+			copyFrom(other);
+		}
+
+		inplace_function(const inplace_function& other)
+		{
+			copyFrom(other);
+		}
+
+		inplace_function(inplace_function&& other) noexcept
+		{
+			moveFrom(other);
+		}
+
+		inplace_function& operator=(const inplace_function& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				copyFrom(other);
+			}
+			return *this;
+		}
+
+		inplace_function& operator=(inplace_function&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				moveFrom(other);
+			}
+			return *this;
+		}
+
+		inplace_function& operator=(std::nullptr_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+
+		~inplace_function()
+		{
+			reset();
+		}
+
+		R operator()(Args... args) const
+		{
+			if (!mVTable)
+			{
+				throw std::bad_function_call{};
+			}
+			return mVTable->invoke(const_cast<void*>(static_cast<const void*>(&mStorage)), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return mVTable != nullptr;
+		}
+
+		void swap(inplace_function& other) noexcept
+		{
+			inplace_function temporary(std::move(other));
+			other = std::move(*this);
+			*this = std::move(temporary);
+		}
+
+	private:
+		template <typename, size_t, size_t>
+		friend class inplace_function;
+
+		template <size_t OtherCapacity, size_t OtherAlignment>
+		void copyFrom(const inplace_function<R(Args...), OtherCapacity, OtherAlignment>& other)
+		{
+			if (other.mVTable)
+			{
+				other.mVTable->copy(&other.mStorage, &mStorage);
+				mVTable = other.mVTable;
+			}
+		}
+
+		void moveFrom(inplace_function& other) noexcept
+		{
+			if (other.mVTable)
+			{
+				other.mVTable->move(&other.mStorage, &mStorage);
+				mVTable = std::exchange(other.mVTable, nullptr);
+			}
+		}
+
+		void reset() noexcept
+		{
+			if (mVTable)
+			{
+				mVTable->destroy(&mStorage);
+				mVTable = nullptr;
+			}
+		}
+
+		// nullptr when empty - not the address of a shared "empty" table, which is not unique across shared libraries
+		const VTable*				mVTable		= nullptr;
+		alignas(Alignment) std::byte	mStorage[Capacity];
+	};
+
+	template <typename Signature, size_t Capacity, size_t Alignment>
+	bool operator==(const inplace_function<Signature, Capacity, Alignment>& function, std::nullptr_t) noexcept
+	{
+		return !function;
+	}
+
+	template <typename Signature, size_t Capacity, size_t Alignment>
+	bool operator!=(const inplace_function<Signature, Capacity, Alignment>& function, std::nullptr_t) noexcept
+	{
+		return static_cast<bool>(function);
+	}
+}
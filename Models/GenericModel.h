@@ -1,18 +1,18 @@
 #pragma once
 
+#include "InplaceFunction.h"
+
 #include <QAbstractTableModel>
 #include <QHash>
 #include <QDebug>
 
-#include <functional>
-
 template <class Underlying, class Columns, template <class...> class Container = QVector>
 class GenericModel : public QAbstractTableModel
 {
 public:
 	using ModelType = GenericModel<Underlying, Columns, Container>;
-	using GetterMap	= QHash<int, std::function<QVariant(const Underlying&)>>;
-	using SetterMap	= QHash<int, std::function<void(Underlying&, const QVariant& data)>>;
+	using GetterMap	= QHash<int, foo::inplace_function<QVariant(const Underlying&), 64>>;
+	using SetterMap	= QHash<int, foo::inplace_function<void(Underlying&, const QVariant& data), 64>>;
 
 	using BackendType		= Container<Underlying>;
 	using UnderlyingType	= Underlying;
@@ -1,11 +1,11 @@
 #pragma once
 
+#include "InplaceFunction.h"
 #include "StoredValue.h"
 
 #include <QSettings>
 #include <QString>
 
-#include <functional>
 #include <type_traits>
 
 namespace
@@ -28,6 +28,10 @@ template <typename T, typename U = T>
 class QSettingsStoredValue : public StoredValue<T>
 {
 public:
+	/** Serializers are stored inline (never allocated), so they may capture at most 64 bytes */
+	using Serializer	= foo::inplace_function<U(T), 64>;
+	using Deserializer	= foo::inplace_function<T(U), 64>;
+
 	/**
 	 * Constructor
 	 *
@@ -40,8 +44,8 @@ public:
 	QSettingsStoredValue(QSettings& settings_ref,
 						 QString key,
 						 QVariant default_value = {},
-						 std::function<U(T)> serializer = identity,
-						 std::function<T(U)> deserializer = identity)
+						 Serializer serializer = identity,
+						 Deserializer deserializer = identity)
 		: mSettingsRef(settings_ref)
 		, mKey(std::move(key))
 		, mDefaultValue(std::move(default_value))
@@ -65,6 +69,6 @@ private:
 	QString mKey;
 	QVariant mDefaultValue;
 	QSettings& mSettingsRef;
-	std::function<U(T)> mSerializer;
-	std::function<T(U)> mDeserializer;
+	Serializer mSerializer;
+	Deserializer mDeserializer;
 };
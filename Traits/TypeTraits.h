@@ -2,9 +2,40 @@
 
 #include <iterator>
 #include <type_traits>
+#include <utility>
+
+/**
+ * C++20 builds check the traits below with concepts, which the compiler instantiates with less work (and memory) than the
+ * SFINAE detectors they replace. Define FOO_NO_CONCEPTS to force the C++17 implementation, e.g. to compare the build
+ * with TypeTraits_compilebench.cpp.
+ */
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L && !defined(FOO_NO_CONCEPTS)
+#define FOO_HAS_CONCEPTS 1
+#endif
+
+#if __has_include(<QtCore/qtypeinfo.h>)
+#include <QtCore/qtypeinfo.h>
+#define FOO_HAS_QTYPEINFO 1
+#endif
 
 namespace foo::traits
 {
+#if defined(FOO_HAS_CONCEPTS)
+	/**
+	 * TestedType is Template<...>, or is derived from one
+	 */
+	template <class TestedType, template <typename...> class Template>
+	concept SpecializationOf = requires (TestedType* tested)
+	{
+		[]<typename... AA>(Template<AA...>*){}(tested);
+	};
+
+	template <template <typename...> class Template, class TestedType>
+	struct IsSpecializationOf : std::bool_constant<SpecializationOf<TestedType, Template>> {};
+
+	template <template <typename...> class Template, class TestedType>
+	constexpr bool IsSpecializationOf_v = SpecializationOf<TestedType, Template>;
+#else
 	template <template <typename...> class Template, class TestedType>
 	struct IsSpecializationOf
 	{
@@ -18,6 +49,7 @@ namespace foo::traits
 
 	template <template <typename...> class Template, class TestedType>
 	constexpr bool IsSpecializationOf_v = IsSpecializationOf<Template, TestedType>::value;
+#endif
 
 
 	template <typename T>
@@ -30,6 +62,31 @@ namespace foo::traits
 	using FirstTemplateParameter_t = typename FirstTemplateParameter<T>::Type;
 
 
+#if defined(FOO_HAS_CONCEPTS)
+	template <class F, class... Args>
+	concept Callable = requires (F&& f, Args&&... args)
+	{
+		std::forward<F>(f)(std::forward<Args>(args)...);
+	};
+
+	template <class T>
+	concept Subscriptable = requires (T& t)
+	{
+		t[0];
+	};
+
+	template <class F, class...Args>
+	struct IsCallable : std::bool_constant<Callable<F, Args...>> {};
+
+	template <class F, class...Args>
+	constexpr bool IsCallable_v = Callable<F, Args...>;
+
+	template <class T>
+	struct HasSubscriptOperator : std::bool_constant<Subscriptable<T>> {};
+
+	template <class T>
+	constexpr bool HasSubscriptOperator_v = Subscriptable<T>;
+#else
 	template <class F, class...Args>
 	struct IsCallable
 	{
@@ -57,6 +114,62 @@ namespace foo::traits
 
 	template <class T>
 	constexpr bool HasSubscriptOperator_v = HasSubscriptOperator<T>::value;
+#endif
+
+
+	template <class, class = std::void_t<>>
+	struct HasReserve : std::false_type {};
+
+	template <class T>
+	struct HasReserve<
+		T,
+		std::void_t<decltype (std::declval<T&>().reserve(std::declval<T&>().size()))>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasReserve_v = HasReserve<T>::value;
+
+
+	template <class, class = std::void_t<>>
+	struct HasCapacity : std::false_type {};
+
+	template <class T>
+	struct HasCapacity<
+		T,
+		std::void_t<decltype (std::declval<const T&>().capacity())>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasCapacity_v = HasCapacity<T>::value;
+
+
+	template <class, class = std::void_t<>>
+	struct HasSize : std::false_type {};
+
+	template <class T>
+	struct HasSize<
+		T,
+		std::void_t<decltype (std::size(std::declval<T&>()))>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasSize_v = HasSize<T>::value;
+
+
+	/**
+	 * Anything iterable with std::begin()/std::end() - including unsized ranges, whose end is a sentinel (e.g. C++20 generators)
+	 */
+	template <class, class = std::void_t<>>
+	struct IsRange : std::false_type {};
+
+	template <class T>
+	struct IsRange<
+		T,
+		std::void_t<decltype (std::begin(std::declval<T&>())), decltype (std::end(std::declval<T&>()))>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool IsRange_v = IsRange<std::remove_reference_t<T>>::value;
 
 
 	// moved from eCATS
@@ -107,6 +220,133 @@ namespace foo::traits
 	template <typename Container>
 	using ValueTypeOf = std::remove_const_t<std::remove_reference_t<decltype(*std::begin(std::declval<Container>()))>>;
 
+	/**
+	 * Heuristic telling containers, that own their elements (and can grow), from views/ranges referring to someone else's elements
+	 */
+	template <class, class = std::void_t<>>
+	struct IsOwningContainer : std::false_type {};
+
+	template <class T>
+	struct IsOwningContainer<
+		T,
+		std::void_t<decltype (std::declval<T&>().push_back(std::declval<ValueTypeOf<T&>>()))>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool IsOwningContainer_v = IsOwningContainer<std::remove_reference_t<T>>::value;
+
+
+	/**
+	 * Container storing its elements in a single array, accessible via std::data()
+	 */
+	template <class, class = std::void_t<>>
+	struct IsContiguousContainer : std::false_type {};
+
+	template <class T>
+	struct IsContiguousContainer<
+		T,
+		std::void_t<decltype (std::data(std::declval<T&>())), decltype (std::size(std::declval<T&>()))>
+	> : std::is_same<std::remove_cv_t<std::remove_pointer_t<decltype (std::data(std::declval<T&>()))>>, ValueTypeOf<T&>> {};
+
+	template <class T>
+	constexpr bool IsContiguousContainer_v = IsContiguousContainer<std::remove_reference_t<T>>::value;
+
+
+	template <class, class = std::void_t<>>
+	struct HasResize : std::false_type {};
+
+	template <class T>
+	struct HasResize<
+		T,
+		std::void_t<decltype (std::declval<T&>().resize(std::declval<T&>().size()))>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasResize_v = HasResize<T>::value;
+
+
+	template <class, class = std::void_t<>>
+	struct HasShrinkToFit : std::false_type {};
+
+	template <class T>
+	struct HasShrinkToFit<
+		T,
+		std::void_t<decltype (std::declval<T&>().shrink_to_fit())>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasShrinkToFit_v = HasShrinkToFit<T>::value;
+
+
+	/** Qt's name for shrink_to_fit() */
+	template <class, class = std::void_t<>>
+	struct HasSqueeze : std::false_type {};
+
+	template <class T>
+	struct HasSqueeze<
+		T,
+		std::void_t<decltype (std::declval<T&>().squeeze())>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool HasSqueeze_v = HasSqueeze<T>::value;
+
+
+	/**
+	 * Container capabilities - the algorithms pick the cheapest valid code path based on these at compile time
+	 */
+	template <class, class = std::void_t<>>
+	struct IsRandomAccess : std::false_type {};
+
+	template <class T>
+	struct IsRandomAccess<
+		T,
+		std::void_t<typename std::iterator_traits<decltype (std::begin(std::declval<T&>()))>::iterator_category>
+	> : std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<decltype (std::begin(std::declval<T&>()))>::iterator_category> {};
+
+	template <class T>
+	constexpr bool IsRandomAccess_v = IsRandomAccess<std::remove_reference_t<T>>::value;
+
+
+	/** Can reserve() the capacity for the size() of another container */
+	template <class T>
+	struct IsReservable : std::bool_constant<HasReserve_v<T> && HasSize_v<T>> {};
+
+	template <class T>
+	constexpr bool IsReservable_v = IsReservable<std::remove_reference_t<T>>::value;
+
+
+	/**
+	 * Type that can be moved to another address by copying its bytes (and forgetting the original),
+	 * i.e. trivially copyable types, and the types Qt declares relocatable (Q_DECLARE_TYPEINFO(T, Q_RELOCATABLE_TYPE))
+	 */
+	template <class T>
+	struct IsTriviallyRelocatable : std::bool_constant<std::is_trivially_copyable_v<T>
+	#if defined(FOO_HAS_QTYPEINFO)
+		|| QTypeInfo<T>::isRelocatable
+	#endif
+	> {};
+
+	template <class T>
+	constexpr bool IsTriviallyRelocatable_v = IsTriviallyRelocatable<std::remove_cv_t<T>>::value;
+
+
+	/**
+	 * Implicitly shared (copy-on-write) Qt container - calling its non-const members (e.g. begin()) detaches it,
+	 * which deep copies the elements whenever the data is shared
+	 */
+	template <class, class = std::void_t<>>
+	struct IsImplicitlyShared : std::false_type {};
+
+	template <class T>
+	struct IsImplicitlyShared<
+		T,
+		std::void_t<decltype (std::declval<const T&>().isDetached()), decltype (std::declval<T&>().detach())>
+	> : std::true_type {};
+
+	template <class T>
+	constexpr bool IsImplicitlyShared_v = IsImplicitlyShared<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
 	template <typename>
 	struct IsTemplate : std::false_type {};
 
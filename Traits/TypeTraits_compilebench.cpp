@@ -0,0 +1,81 @@
+/**
+ * Compile-time benchmark of the TypeTraits.h detectors
+ *
+ * A synthetic translation unit instantiating IsCallable, IsSpecializationOf and HasSubscriptOperator (the way
+ * Async.h and the Algorithms headers do) for FOO_COMPILEBENCH_TYPES distinct types. It has no runtime part -
+ * what is measured is the time and memory the compiler needs to build it.
+ *
+ * @example: (concepts vs. the C++17 SFINAE detectors, with the same compiler)
+ *
+	/usr/bin/time -v g++ -std=c++20 -fsyntax-only -I. TypeTraits_compilebench.cpp
+	/usr/bin/time -v g++ -std=c++20 -fsyntax-only -I. -DFOO_NO_CONCEPTS TypeTraits_compilebench.cpp
+	/usr/bin/time -v g++ -std=c++17 -fsyntax-only -I. TypeTraits_compilebench.cpp
+
+ * Compare "Elapsed (wall clock) time" and "Maximum resident set size"; -ftime-report (GCC) or -ftime-trace (Clang)
+ * break the time down further. Scale the TU with -DFOO_COMPILEBENCH_TYPES=<count>.
+ */
+
+#include "TypeTraits.h"
+
+#include <utility>
+
+#ifndef FOO_COMPILEBENCH_TYPES
+#define FOO_COMPILEBENCH_TYPES 2000
+#endif
+
+namespace
+{
+	template <int N>
+	struct Value
+	{
+		int operator[](int) const { return N; }
+	};
+
+	template <int N>
+	struct Result {};
+
+	template <typename... Ts>
+	struct Expected {};
+
+	/** Callback taking the result - the onDone() overload resolution of Async.h */
+	template <int N>
+	struct Callback
+	{
+		void operator()(Value<N>) const {}
+	};
+
+	/** Callback ommiting the result */
+	template <int N>
+	struct Notification
+	{
+		void operator()() const {}
+	};
+
+	template <int N>
+	constexpr int traits_of()
+	{
+		using namespace foo::traits;
+
+		return IsCallable_v<Callback<N>, Value<N>>
+			 + IsCallable_v<Notification<N>, Value<N>>
+			 + IsCallable_v<Callback<N>, Result<N>>
+			 + IsSpecializationOf_v<Expected, Expected<Value<N>, Result<N>>>
+			 + IsSpecializationOf_v<Expected, Value<N>>
+			 + HasSubscriptOperator_v<Value<N>>
+			 + HasSubscriptOperator_v<Result<N>>;
+	}
+
+	template <int... N>
+	constexpr int all_traits(std::integer_sequence<int, N...>)
+	{
+		return (0 + ... + traits_of<N>());
+	}
+
+	// 3 of the 7 traits hold for each type
+	static_assert(all_traits(std::make_integer_sequence<int, FOO_COMPILEBENCH_TYPES>{}) == 3 * FOO_COMPILEBENCH_TYPES);
+}
+
+int main()
+{
+	return 0;
+}